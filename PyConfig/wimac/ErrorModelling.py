@@ -33,7 +33,7 @@
 """
 
 from openwns.pyconfig import Frozen, Sealed, attrsetter
-from wimac.LLMapping import WIMAXMapper
+from wimac.LLMapping import WIMAXMapper, PhyModeTable
 #from support.WiMACParameters import ParametersOFDM
 
 class MappingObject(Sealed):
@@ -238,6 +238,45 @@ cir2ser_QAM64_23 = Cir2SerMapping(rawQAM64_23)
 cir2ser_QAM64_34 = Cir2SerMapping(rawQAM64_34)
 
 
+class PERTable(Sealed):
+    """Precomputed PER over SINR x block size for all PhyModes of the
+       phyModeMapping, interpolated bilinearly.
+
+       Each cell is compared with the exact mapping on a grid of
+       checkPoints + 1 points per axis. Cells deviating more than maxError
+       there, and points outside the table, are evaluated exactly. maxError
+       is only verified at these points, not guaranteed between them.
+    """
+    minSINR = -10.0
+    maxSINR = 30.0
+    sinrResolution = 0.1
+
+    minBlockSize = 0
+    maxBlockSize = 4096
+    blockSizeResolution = 128
+
+    maxError = 1e-3
+    checkPoints = 4
+
+    def __init__(self, **kw):
+        attrsetter(self, kw)
+
+
+class EarlyDecision(Sealed):
+    """Draws the CRC outcome right after the batch evaluation in the
+       DataCollector (see DataCollector.batchErrorModelling). Failed
+       compounds are counted in the loss ratio probe of the CRC and
+       dropped there, compounds decoded by HARQ are not affected.
+    """
+    lossRatioProbeName = "wimac.crc.CRCLossRatio"
+    dataCollectors = ['dlscheduler', 'ulscheduler']
+    """ At least one of them must set batchErrorModelling to this
+    ErrorModelling """
+
+    def __init__(self, **kw):
+        attrsetter(self, kw)
+
+
 class ErrorModelling(Sealed):
     """This class mappes the cir to ser and calculate PER
 
@@ -249,6 +288,15 @@ class ErrorModelling(Sealed):
     cirProvider = None
     phyModeProvider = None
     phyModeMapping = None
+    perTable = None
+    """ None evaluates the exact mapping for every compound, set a
+    PERTable() to interpolate instead """
+    phyModeTable = None
+    """ Finds the PhyMode's row in the perTable """
+    linkAdaptation = None
+    """ Name of the LinkAdaptation service the PER is reported to """
+    earlyDecision = None
+    """ None leaves the decision to the CRC """
 
     cir2ser_BPSK12 = None
     cir2ser_QPSK12 = None
@@ -265,6 +313,7 @@ class ErrorModelling(Sealed):
         symbolDuration = symbolDuration_
         subCarriersPerSubChannel = dataSubCarrier_ # 192
         self.phyModeMapping = WIMAXMapper(symbolDuration, subCarriersPerSubChannel)
+        self.phyModeTable = PhyModeTable()
         self.cir2ser_BPSK12 = cir2ser_BPSK12
         self.cir2ser_QPSK12 = cir2ser_QPSK12
         self.cir2ser_QPSK34 = cir2ser_QPSK34
@@ -35,8 +35,34 @@ class ClassifierMock(Sealed):
     __plugin__ = 'wimac.ClassifierMock'
 
 
+class ACKAggregation(Sealed):
+    """ Merges the ACKs sent to one peer during a frame into a single
+    compound on its basic connection, sent at the start of the next
+    frame. mode 'cumulative' keeps only the newest ACK per connection and
+    requires a GoBackN or CumulativeACK ARQ, mode 'bitmap' acknowledges
+    every ACK with one bit.
+    """
+    mode = None
+    headerSize = None
+    cidSize = None
+    snSize = None
+    frameBuilder = None
+    """ Signals the frame starts, None if the owner calls
+    messageNewFrame itself """
+
+    def __init__(self, mode = 'bitmap', headerSize = 48, cidSize = 16, snSize = 11,
+                 frameBuilder = 'frameBuilder'):
+        self.mode = mode
+        self.headerSize = headerSize
+        self.cidSize = cidSize
+        self.snSize = snSize
+        self.frameBuilder = frameBuilder
+
+
 class ACKSwitch(Sealed):
     __plugin__ = 'wimac.ACKSwitch'
+    aggregation = None
+    """ None sends every ACK in a compound of its own """
 
 
 class PhyUser(Sealed):
@@ -45,3 +71,40 @@ class PhyUser(Sealed):
 
 class UpperConvergence(Sealed):
     __plugin__ = 'wimac.UpperConvergence'
+
+
+class SDUPacking(Sealed):
+    """ Packs the SDUs of one CID into a single MAC PDU. Placed between the
+    classifier and the scheduler, SDUs are collected until the next one
+    would exceed targetSize or the first one has waited for maxDelay.
+    """
+    __plugin__ = 'wimac.SDUPacking'
+    targetSize = None
+    maxDelay = None
+    subHeaderSize = None
+    """ Packing subheader per SDU in Bit """
+    classifier = None
+
+    def __init__(self, targetSize, maxDelay, subHeaderSize = 16, classifier = 'classifier'):
+        self.targetSize = targetSize
+        self.maxDelay = maxDelay
+        self.subHeaderSize = subHeaderSize
+        self.classifier = classifier
+
+
+class BufferOccupancy(Sealed):
+    """ Counts compounds entering (mode 'enqueue') or leaving (mode
+    'dequeue') a buffer. The size unit is taken from the buffer config,
+    the enqueue instance reads the size of the buffer named by buffer.
+    """
+    __plugin__ = 'wimac.BufferOccupancy'
+    mode = None
+    buffer = None
+    sizeUnit = None
+    classifier = None
+
+    def __init__(self, mode, bufferConfig, buffer = 'buffer', classifier = 'classifier'):
+        self.mode = mode
+        self.buffer = buffer
+        self.sizeUnit = bufferConfig.sizeUnit
+        self.classifier = classifier
@@ -40,32 +40,86 @@ class FrameHeadCollector(openwns.FCF.CompoundCollector):
         self.phyMode = phyMode
 
 
+class MapSizing(Sealed):
+    """ Size of the DL-MAP and UL-MAP.
+
+    format is one of 'normal', 'compressed' and 'subMap'. The normal
+    header and IE sizes are parametersPhy.mapBase and parametersPhy.ie.
+    """
+    format = None
+    compressedHeaderBits = None
+    compressedIEBits = None
+    subMapHeaderBits = None
+    subMapPointerBits = None
+    # PhyModes of the sub-MAPs, bursts go to the most efficient one their
+    # own PhyMode allows
+    subMapPhyModes = None
+
+    def __init__(self, format = 'normal', subMapPhyModes = None, **kw):
+        self.format = format
+        self.compressedHeaderBits = 40
+        self.compressedIEBits = 32
+        self.subMapHeaderBits = 48
+        self.subMapPointerBits = 24
+        if subMapPhyModes is None:
+            subMapPhyModes = []
+        self.subMapPhyModes = subMapPhyModes
+        attrsetter(self, kw)
+
+
 class DLMapCollector(openwns.FCF.CompoundCollector):
     __plugin__ = "wimac.frame.DLMapCollector"
     dlSchedulerName = None
     phyMode = None
+    mapSizing = None
     
-    def __init__(self, frameBuilder, dlSchedulerName, phyMode):
+    def __init__(self, frameBuilder, dlSchedulerName, phyMode, mapSizing = None):
         openwns.FCF.CompoundCollector.__init__(self, frameBuilder)
         self.dlSchedulerName = dlSchedulerName
         self.phyMode = phyMode
+        if mapSizing is None:
+            mapSizing = MapSizing()
+        self.mapSizing = mapSizing
 
 
 class ULMapCollector(openwns.FCF.CompoundCollector):
     __plugin__ = "wimac.frame.ULMapCollector"
     ulSchedulerName = None
     phyMode = None
+    mapSizing = None
 
-    def __init__(self, frameBuilder, ulSchedulerName, phyMode):
+    def __init__(self, frameBuilder, ulSchedulerName, phyMode, mapSizing = None):
         openwns.FCF.CompoundCollector.__init__(self, frameBuilder)
         self.ulSchedulerName = ulSchedulerName
         self.phyMode = phyMode
+        if mapSizing is None:
+            mapSizing = MapSizing()
+        self.mapSizing = mapSizing
+
+class AdaptiveTDD(Sealed):
+    """ Splits the time slots of the DL and UL data phases by backlog.
+
+    Configured at the DL DataCollector of the BS. Both schedulers need
+    the same slot duration.
+    """
+    minDLTimeSlots = None
+    maxDLTimeSlots = None
+    ulSchedulerName = None
+
+    def __init__(self, minDLTimeSlots, maxDLTimeSlots, ulSchedulerName = 'ulscheduler'):
+        self.minDLTimeSlots = minDLTimeSlots
+        self.maxDLTimeSlots = maxDLTimeSlots
+        self.ulSchedulerName = ulSchedulerName
 
 class DataCollector(openwns.FCF.CompoundCollector):
     __plugin__ = "wimac.frame.DataCollector"
 
     txScheduler = None
     rxScheduler = None
+    adaptiveTDD = None
+    batchErrorModelling = None
+    """ Name of the ErrorModelling FU. If set, the PER of all compounds
+    received at the same time is evaluated in one batch before delivery """
 
     def __init__(self, frameBuilder):
         openwns.FCF.CompoundCollector.__init__(self, frameBuilder)
@@ -129,11 +183,17 @@ class TimingControl(Sealed):
     activations = None
     phaseDescriptor = None
     frameStartupDelay = None
+    # phases finishing early (e.g. short MAPs) hand their time to the next phase
+    elasticPhases = None
+    # cells without any queued data skip the activations of a frame
+    skipIdleFrames = None
 
     def __init__(self):
         self.activations = []
         self.phaseDescriptor = []
         self.frameStartupDelay = 0.0
+        self.elasticPhases = False
+        self.skipIdleFrames = False
         
     def addActivation(self, activation):
         assert isinstance(activation, Activation)
@@ -32,6 +32,16 @@ from openwns.interval import Interval
 
 from rise.PhyMode import PhyMode,PhyModeMapper
 
+class PhyModeTable(Sealed):
+    """ Constant time SINR -> PhyMode selection in bins of resolution dB.
+    Outside [minSINR, maxSINR) the PhyModeMapper is asked. """
+    minSINR = -10.0
+    maxSINR = 40.0
+    resolution = 0.01
+
+    def __init__(self, **kw):
+        attrsetter(self, kw)
+
 # Mappings for PER = 0.0001
 class WIMAXMapper(PhyModeMapper):
     lowestPhyMode = None
@@ -85,6 +85,8 @@ class Layer2(openwns.node.Component):
     upperconvergence = None
     classifier = None
     synchronizer = None
+    sduPacking = None
+    """ wimac.FUs.SDUPacking below the classifier, None disables packing """
 
     FlowSeparator = None
     crc = None
@@ -136,15 +138,26 @@ class Layer2(openwns.node.Component):
         interferenceCache.notFoundStrategy.deviationInterference = "0.0 mW"
         interferenceCache.notFoundStrategy.averagePathloss = "131.0 dB"
         self.managementServices.append( interferenceCache )
+
+        self.managementServices.append(
+            wimac.Services.LinkAdaptation( "linkAdaptation" ))
         
         self.classifier = wimac.FUs.Classifier()
         self.synchronizer = openwns.Tools.Synchronizer()
+        self.sduPacking = config.parametersMAC.sduPacking
 
         self.subFUN = openwns.FUN.FUN()
-        subFUNbuffer = openwns.FUN.Node('buffer', openwns.Buffer.Dropping( size = 320000,
+        bufferConfig = openwns.Buffer.Dropping( size = 320000,
                                        sizeUnit = 'Bit',
                                        lossRatioProbeName = "wimac.buffer.lossRatio",
-                                       sizeProbeName = "wimac.buffer.size"))
+                                       sizeProbeName = "wimac.buffer.size")
+        subFUNbuffer = openwns.FUN.Node('buffer', bufferConfig)
+
+        # Keep the per CID buffer occupancy of the Component up to date
+        subFUNoccupancyIn = openwns.FUN.Node('bufferOccupancyIn', wimac.FUs.BufferOccupancy(
+                                       'enqueue', bufferConfig))
+        subFUNoccupancyOut = openwns.FUN.Node('bufferOccupancyOut', wimac.FUs.BufferOccupancy(
+                                       'dequeue', bufferConfig))
         
         # Only used for reassembly in receiver. Segmentation is done in scheduler queue
         subFUNsegAndConcat = openwns.FUN.Node('deSegAndDeConcat', openwns.SAR.SegAndConcat(
@@ -157,11 +170,15 @@ class Layer2(openwns.node.Component):
         # Should work even if packet size is one bit 
         subFUNsegAndConcat.config.reorderingWindow.snFieldLength = 20 
                                         
+        self.subFUN.add(subFUNoccupancyIn)
         self.subFUN.add(subFUNbuffer)
+        self.subFUN.add(subFUNoccupancyOut)
         self.subFUN.add(subFUNsegAndConcat) 
-        subFUNbuffer.connect(subFUNsegAndConcat)
+        subFUNoccupancyIn.connect(subFUNbuffer)
+        subFUNbuffer.connect(subFUNoccupancyOut)
+        subFUNoccupancyOut.connect(subFUNsegAndConcat)
         
-        self.group = openwns.Group.Group(self.subFUN, 'buffer', 'deSegAndDeConcat')
+        self.group = openwns.Group.Group(self.subFUN, 'bufferOccupancyIn', 'deSegAndDeConcat')
         
         creator = openwns.FlowSeparator.Config('flowSeparatorPrototype', self.group)
         ifNotFoundStrategy = openwns.FlowSeparator.CreateOnFirstCompound(creator)
@@ -219,6 +236,8 @@ class Layer2(openwns.node.Component):
         self.dlscheduler = Node('dlscheduler', self.dlscheduler)
         self.ulscheduler = Node('ulscheduler', self.ulscheduler)
         self.frameBuilder = Node('frameBuilder', self.frameBuilder)
+        if self.sduPacking is not None:
+            self.sduPacking = Node('sduPacking', self.sduPacking)
 
         #Dataplane
 
@@ -246,6 +265,17 @@ class Layer2(openwns.node.Component):
         self.frameBuilder,
         )
 
+        if self.sduPacking is not None:
+            self.fun.add(self.sduPacking)
+
+    def connectClassifier(self):
+        # The SDUPacking, if any, sits between classifier and synchronizer
+        if self.sduPacking is None:
+            self.classifier.connect(self.synchronizer)
+        else:
+            self.classifier.connect(self.sduPacking)
+            self.sduPacking.connect(self.synchronizer)
+
     def setPhyDataTransmission(self, serviceName):
         self.phyDataTransmission = serviceName
 
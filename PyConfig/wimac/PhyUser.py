@@ -44,6 +44,13 @@ class PhyUser(Sealed):
     pathlossProbeName = None
     phyTraceProbeName = None
 
+    foreignFrameHeadInterval = None
+    """ Minimum time between two frame heads accepted from the same foreign
+    base station. 0.0 accepts all of them. """
+
+    monitorForeignCells = None
+    """ Keep measuring sampled frame heads of foreign cells while associated """
+
     def __init__(self, **kw):
         self.iProbeName = "wimac.interferenceSDMA"
         self.cirProbeName = "wimac.cirSDMA"
@@ -58,5 +65,7 @@ class PhyUser(Sealed):
         self.cirContentionProbeName = "wimac.cirContention"      
         self.pathlossProbeName = "wimac.pathloss"      
         self.phyTraceProbeName = "wimac.phyTrace"      
+        self.foreignFrameHeadInterval = 0.0
+        self.monitorForeignCells = False
         attrsetter(self, kw)
 
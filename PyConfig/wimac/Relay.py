@@ -31,7 +31,19 @@ class BSRelayMapper(Sealed):
     __plugin__ = "wimac.relay.BSRelayMapper"
 
 class RSRelayMapper(Sealed):
-    __plugin__ = "wimac.relay.RSRelayMapper"    
+    __plugin__ = "wimac.relay.RSRelayMapper"
+    forwardInPlace = None
+    """ Rewrite the CIDs of a relayed compound in place instead of
+    copying the upper commands into a new compound """
+    resetFUs = None
+    """ Names of the FUs below the relay mapper whose commands are reset
+    before a compound is forwarded in place. Must include at least the
+    PhyUser, ErrorModelling and CRC FUs """
+
+    def __init__(self, forwardInPlace = False,
+                 resetFUs = ['crc', 'errormodelling', 'phyUser']):
+        self.forwardInPlace = forwardInPlace
+        self.resetFUs = list(resetFUs)
 
 class SSRelayMapper(Sealed):
     __plugin__ = "wimac.relay.SSRelayMapper"
@@ -35,6 +35,7 @@ import openwns.Scheduler
 import openwns.scheduler
 #from support.WiMACParameters import ParametersOFDM, ParametersSystem
 from support.WiMACParameters import ParametersSystem
+from wimac.LLMapping import PhyModeTable
 
 class PhyModeMapper:
     """ put SINR-Bps lookup table here
@@ -45,6 +46,13 @@ class PhyModeMapper:
 class RegistryProxyWiMAC(openwns.Scheduler.RegistryProxy):
     nameInRegistryProxyFactory = "RegistryProxyWiMAC"
     phyModeMapper = None
+    phyModeTable = None
+    """ None selects PhyModes through the phyModeMapper """
+    linkAdaptation = None
+    """ Name of the LinkAdaptation service whose offsets correct the SINR
+    estimates """
+    relayCoordination = None
+    """ None lets BS and RS schedule independently """
     queueSize = 320000   ## maximum of 0.32MBit in one queue,
                          ## that would be 5ms at 64MBps
     powerCapabilitiesUT = None
@@ -56,6 +64,7 @@ class RegistryProxyWiMAC(openwns.Scheduler.RegistryProxy):
     
     def __init__(self, isDL = True):
         self.isDL = isDL
+        self.phyModeTable = PhyModeTable()
         
     def setPhyModeMapper(self, phyModeMapper, ):
         self.phyModeMapper = phyModeMapper
@@ -70,6 +79,20 @@ class RegistryProxyWiMAC(openwns.Scheduler.RegistryProxy):
                                                                     ParametersSystem.txPower['FRS'],
                                                                     ParametersSystem.txPower['FRS'])
 
+class RelayCoordination(Sealed):
+    """ Lets the DL scheduler of the BS hold back relay connections while
+    the RS still holds enough data for the access link. The RS is
+    weighted by the backlog it holds for the access link. """
+    drainTimeLimit = None
+    """ Airtime on one subchannel the RS may need to forward its backlog
+    of a connection before the BS stops feeding it """
+    backlogPerUser = None
+    """ Access backlog at the RS in Bit that weighs as one more user """
+
+    def __init__(self, drainTimeLimit = 0.005, backlogPerUser = 12000):
+        self.drainTimeLimit = drainTimeLimit
+        self.backlogPerUser = backlogPerUser
+
 class SpaceTimeSectorizationRegistryProxy(openwns.Scheduler.RegistryProxy):
     phyModeMapper = None
     nameInRegistryProxyFactory = "SpaceTimeSectorizationRegistryProxy"
@@ -95,6 +118,13 @@ class Scheduler(openwns.FCF.CompoundCollector):
 
     strategy = None
     queue = None
+    # optional queue for compounds on the broadcast CID
+    broadcastQueue = None
+    maxBroadcastTimeSlots = None
+    # compute the schedule of frame n+1 lookaheadDelay after the start of
+    # scheduling in frame n
+    lookahead = None
+    lookaheadDelay = None
     grouper = None
     registry = None
     harq = None
@@ -145,6 +175,9 @@ class Scheduler(openwns.FCF.CompoundCollector):
         self.registry.setPhyModeMapper(mapper)
         self.maxBeams = maxBeams
         self.numberOfTimeSlots = 1
+        self.maxBroadcastTimeSlots = 1
+        self.lookahead = False
+        self.lookaheadDelay = 0.0
         self.freqChannels = 1
         self.beamforming = beamforming
         self.resettedBitsProbeBusName = "wimac.schedulerQueue.resetted.bits"
@@ -152,11 +185,13 @@ class Scheduler(openwns.FCF.CompoundCollector):
         attrsetter(self, kw)
 
 class PseudoBWRequestGenerator(Sealed):
+    """ Writes aggregated bandwidth requests into the queue of the UL
+    scheduler. The queue of the UL scheduler must be a BWRequestQueue.
+    """
     __plugin__ = 'wimac.scheduler.PseudoBWRequestGenerator'
 
     connectionManager = None
     ulScheduler = None
-    classifier = None
     packetSize = None
     pduOverhead = None
 
@@ -165,7 +200,6 @@ class PseudoBWRequestGenerator(Sealed):
         self.connectionManager = _connectionManager
         self.ulScheduler = _ulScheduler
         self.pduOverhead = _pduOverhead
-        self.classifier = 'classifier'
 
 class Callback(Sealed):
     frameOffsetDelayProbeName = "wimac.frameOffsetDelay"
@@ -197,3 +231,19 @@ class BypassQueue(Sealed):
 
     def __init__(self, **kw):
         attrsetter(self, kw)
+
+class BWRequestQueue(Sealed):
+    """ Holds one (bits, PDUs) bandwidth request per CID for the
+    PseudoBWRequestGenerator
+    """
+    __plugin__ = 'wimac.BWRequestQueue'
+    nameInQueueFactory = __plugin__
+    classifier = None
+    maxSize = None
+    """ Maximum number of PDUs requested per CID, like the maxSize of a
+    SimpleQueue """
+
+    def __init__(self, **kw):
+        self.classifier = 'classifier'
+        self.maxSize = 1000
+        attrsetter(self, kw)
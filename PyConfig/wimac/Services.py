@@ -82,6 +82,54 @@ class BestAtGivenTime(AssociationControl):
         self.decisionTime = decisionTime
 
 
+class SleepControl(object):
+    """ Sleep mode (power saving class I) of a subscriber station.
+
+    Add it to the controlServices of a SubscriberStation. Window lengths
+    are given in frames. Idle mode is modelled by a long finalSleepWindow.
+    """
+    __plugin__ = 'wimac.services.SleepControl'
+    serviceName = "sleepControl"
+
+    idleFramesBeforeSleep = None
+    initialSleepWindow = None
+    finalSleepWindow = None
+    listeningWindow = None
+    dlSchedulerName = None
+    ulSchedulerName = None
+
+    def __init__(self, idleFramesBeforeSleep = 10, initialSleepWindow = 2,
+                 finalSleepWindow = 64, listeningWindow = 1, dlSchedulerName = 'dlscheduler',
+                 ulSchedulerName = 'ulscheduler'):
+        self.idleFramesBeforeSleep = idleFramesBeforeSleep
+        self.initialSleepWindow = initialSleepWindow
+        self.finalSleepWindow = finalSleepWindow
+        self.listeningWindow = listeningWindow
+        self.dlSchedulerName = dlSchedulerName
+        self.ulSchedulerName = ulSchedulerName
+
+
+class LinkAdaptation(object):
+    """ Outer loop link adaptation: one SINR offset per link, moved by the
+    decoding outcomes towards targetBLER. Used if the ErrorModelling and the
+    RegistryProxyWiMAC name this service in their linkAdaptation attribute.
+    """
+    __plugin__ = 'wimac.services.LinkAdaptation'
+
+    targetBLER = None
+    stepDown = None
+    minOffset = None
+    maxOffset = None
+
+    def __init__(self, serviceName = "linkAdaptation", targetBLER = 0.1, stepDown = 0.5,
+                 minOffset = -10.0, maxOffset = 10.0):
+        self.serviceName = serviceName
+        self.targetBLER = targetBLER
+        self.stepDown = stepDown
+        self.minOffset = minOffset
+        self.maxOffset = maxOffset
+
+
 class ConstantValue(object):
     __plugin__ = 'wimac.services.InterferenceCache.ConstantValue'
     
@@ -115,6 +115,16 @@ class BaseStation(Layer2):
             usePadding = True,
             delayProbeName = self.schedQueueTick.commandName)
 
+        self.dlscheduler.txScheduler.broadcastQueue = openwns.Scheduler.SegmentingQueue(
+            "deSegAndDeConcat",
+            "deSegAndDeConcat",
+            self.logger,
+            minimumSegmentSize = 1,
+            fixedHeaderSize = 0,
+            extensionHeaderSize = 0,
+            usePadding = True,
+            delayProbeName = self.schedQueueTick.commandName)
+
         # Use the QueueProxy in UL Master Scheduler
         queueManager = wimac.Services.QueueManager("queueManager", "connectionManager", self.logger)
         self.managementServices.append(queueManager)                      
@@ -139,7 +149,7 @@ class BaseStation(Layer2):
 
         self.topPProbe.connect(self.bufferTick)
         self.bufferTick.connect(self.classifier)
-        self.classifier.connect(self.synchronizer)
+        self.connectClassifier()
         self.synchronizer.connect(self.flowSeparator)
         self.flowSeparator.connect(self.bufferTack)
         self.bufferTack.connect(self.schedQueueTick)
@@ -363,7 +373,7 @@ class SubscriberStation(Layer2):
         self.topTpProbe.connect(self.topPProbe)
         self.topPProbe.connect(self.bufferTick)
         self.bufferTick.connect(self.classifier)
-        self.classifier.connect(self.synchronizer)
+        self.connectClassifier()
         self.synchronizer.connect(self.flowSeparator)
         self.flowSeparator.connect(self.bufferTack)
         self.bufferTack.connect(self.schedQueueTick)
@@ -275,6 +275,11 @@ class ParametersMAC(Frozen):
     # pduOverhead = 48 + 32 # including CRC
     # overhead due to MAC header
 
+    sduPacking = None
+    # e.g. wimac.FUs.SDUPacking(targetSize = 1500, maxDelay = 0.005) to
+    # pack the SDUs of one CID into a single MAC PDU
+    #####
+
     subFrameRatio = 0
     #  sub frame ratio of the uplink frame phase
     #  Reminder: Sub frame is located in the uplink frame phase.
@@ -2,6 +2,7 @@ libname = 'wimac'
 srcFiles = [
      # arranged alphabetically
     'src/ACKSwitch.cpp',
+    'src/BufferOccupancy.cpp',
     'src/Classifier.cpp',
     'src/Component.cpp',
     'src/ConnectionIdentifier.cpp',
@@ -9,22 +10,29 @@ srcFiles = [
     'src/ConnectionRule.cpp',
     'src/ErrorModelling.cpp',
     'src/Logger.cpp',
+    'src/PERTable.cpp',
     'src/PhyAccessFunc.cpp',
+    'src/PhyModeTable.cpp',
     'src/PhyUser.cpp',
     'src/RANG.cpp',
+    'src/SDUPacking.cpp',
     'src/UpperConvergence.cpp',
     'src/Utilities.cpp',
 
     'src/frame/DataCollector.cpp',
     'src/frame/DLMapCollector.cpp',
+    'src/frame/FrameClock.cpp',
     'src/frame/FrameHeadCollector.cpp',
+    'src/frame/MapSizing.cpp',
     'src/frame/TimingControl.cpp',
     'src/frame/ULMapCollector.cpp',
     'src/parameter/PHY.cpp',
     'src/relay/RelayMapper.cpp',
+    'src/scheduler/BWRequestQueue.cpp',
     'src/scheduler/BypassQueue.cpp',
     'src/scheduler/Callback.cpp',
     'src/scheduler/DLCallback.cpp',
+    'src/scheduler/GrantIndex.cpp',
     'src/scheduler/PseudoBWRequestGenerator.cpp',
     'src/scheduler/RegistryProxyWiMAC.cpp',
     'src/scheduler/Scheduler.cpp',
@@ -33,16 +41,21 @@ srcFiles = [
     'src/services/AssociationControl.cpp',
     'src/services/ConnectionManager.cpp',
     'src/services/InterferenceCache.cpp',
+    'src/services/LinkAdaptation.cpp',
     'src/services/QueueManager.cpp',
+    'src/services/SleepControl.cpp',
     'src/services/tests/InterferenceCacheTest.cpp',
     'src/StationManager.cpp',
     'src/tests/ACKSwitchTest.cpp',
+    'src/tests/PERTableTest.cpp',
+    'src/tests/SDUPackingTest.cpp',
     'src/WiMAC.cpp',
     'src/compoundSwitch/filter/RelayDirection.cpp',
     'src/helper/ContextProvider.cpp'
 ]
 hppFiles = [
     'src/ACKSwitch.hpp',
+    'src/BufferOccupancy.hpp',
     'src/CIRProvider.hpp',
     'src/Classifier.hpp',
     'src/Component.hpp',
@@ -53,22 +66,29 @@ hppFiles = [
     'src/ErrorModelling.hpp',
     'src/frame/DataCollector.hpp',
     'src/frame/DLMapCollector.hpp',
+    'src/frame/FrameClock.hpp',
     'src/frame/FrameHeadCollector.hpp',
     'src/frame/MapCommand.hpp',
+    'src/frame/MapSizing.hpp',
     'src/frame/TimingControl.hpp',
     'src/frame/ULMapCollector.hpp',
     'src/FUConfigCreator.hpp',
     'src/Logger.hpp',
     'src/parameter/PHY.hpp',
+    'src/PERTable.hpp',
     'src/PhyAccessFunc.hpp',
     'src/PhyModeProviderCommand.hpp',
+    'src/PhyModeTable.hpp',
     'src/PhyUserCommand.hpp',
     'src/PhyUser.hpp',
     'src/RANG.hpp',
+    'src/SDUPacking.hpp',
     'src/relay/RelayMapper.hpp',
+    'src/scheduler/BWRequestQueue.hpp',
     'src/scheduler/BypassQueue.hpp',
     'src/scheduler/Callback.hpp',
     'src/scheduler/DLCallback.hpp',
+    'src/scheduler/GrantIndex.hpp',
     'src/scheduler/PseudoBWRequestGenerator.hpp',
     'src/scheduler/RegistryProxyWiMAC.hpp',
     'src/scheduler/Scheduler.hpp',
@@ -78,7 +98,9 @@ hppFiles = [
     'src/services/AssociationControl.hpp',
     'src/services/ConnectionManager.hpp',
     'src/services/InterferenceCache.hpp',
+    'src/services/LinkAdaptation.hpp',
     'src/services/QueueManager.hpp',
+    'src/services/SleepControl.hpp',
     'src/services/IChannelQualityObserver.hpp',
     'src/StationManager.hpp',
     'src/UpperConvergence.hpp',
@@ -37,10 +37,12 @@
 #include <WNS/ldk/HasDeliverer.hpp>
 #include <WNS/ldk/Layer.hpp>
 #include <WNS/ldk/arq/ARQ.hpp>
+#include <WNS/ldk/arq/CumulativeACK.hpp>
+#include <WNS/ldk/arq/GoBackN.hpp>
+#include <WNS/ldk/fcf/FrameBuilder.hpp>
 
 #include <WIMAC/services/ConnectionManager.hpp>
 
-
 STATIC_FACTORY_REGISTER_WITH_CREATOR(
     wimac::ACKSwitch,
     wns::ldk::FunctionalUnit,
@@ -50,7 +52,7 @@ STATIC_FACTORY_REGISTER_WITH_CREATOR(
 using namespace wimac;
 using namespace wimac::service;
 
-ACKSwitch::ACKSwitch( wns::ldk::fun::FUN* fun, const wns::pyconfig::View& ):
+ACKSwitch::ACKSwitch( wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config ):
     wns::ldk::CommandTypeSpecifier<AckSwitchCommand>(fun),
     wns::ldk::HasConnector<>(),
     wns::ldk::HasReceptor<>(),
@@ -58,8 +60,32 @@ ACKSwitch::ACKSwitch( wns::ldk::fun::FUN* fun, const wns::pyconfig::View& ):
     wns::ldk::Processor<ACKSwitch>(),
     arq_(0),
     classifier_(0),
-    connectionManager_(0)
+    connectionManager_(0),
+    aggregate_(false),
+    cumulative_(false),
+    headerSize_(0),
+    cidSize_(0),
+    snSize_(0),
+    frameBuilderName_(),
+    pending_(),
+    blocked_(false)
 {
+    if ( config.knows("aggregation") && !config.isNone("aggregation") )
+    {
+        wns::pyconfig::View aggregation = config.getView("aggregation");
+        std::string mode = aggregation.get<std::string>("mode");
+        if ( mode != "cumulative" && mode != "bitmap" )
+            throw wns::Exception("ACKSwitch: unknown ACK aggregation mode " + mode);
+
+        aggregate_ = true;
+        cumulative_ = ( mode == "cumulative" );
+        headerSize_ = aggregation.get<Bit>("headerSize");
+        cidSize_ = aggregation.get<Bit>("cidSize");
+        snSize_ = aggregation.get<Bit>("snSize");
+
+        if ( !aggregation.isNone("frameBuilder") )
+            frameBuilderName_ = aggregation.get<std::string>("frameBuilder");
+    }
 }
 
 void ACKSwitch::onFUNCreated()
@@ -74,6 +100,22 @@ void ACKSwitch::onFUNCreated()
         getFUN()->getLayer()->getManagementService<service::ConnectionManagerInterface>
         ("connectionManager");
     assure( connectionManager_, "ConnectionManager not found in Configuration" );
+
+    // Replacing a pending ACK loses the frames it acknowledged unless
+    // the newer ACK covers them
+    if ( cumulative_
+         && dynamic_cast<wns::ldk::arq::GoBackN*>( arq_ ) == NULL
+         && dynamic_cast<wns::ldk::arq::CumulativeACK*>( arq_ ) == NULL )
+        throw wns::Exception("ACKSwitch: cumulative ACK aggregation needs an ARQ with cumulative ACKs");
+
+    if ( !frameBuilderName_.empty() )
+        getFUN()->findFriend<wns::ldk::fcf::FrameBuilder*>( frameBuilderName_ )->attachObserver( this );
+}
+
+void ACKSwitch::messageNewFrame()
+{
+    if ( !pending_.empty() )
+        flush();
 }
 
 void ACKSwitch::processOutgoing( const wns::ldk::CompoundPtr& compound )
@@ -119,3 +161,160 @@ void ACKSwitch::processIncoming( const wns::ldk::CompoundPtr& compound )
         classifierCommand->peer.id = switchCommand->peer.originalCID;
     }
 }
+
+bool ACKSwitch::isACK( const wns::ldk::CompoundPtr& compound ) const
+{
+    wns::ldk::arq::ARQCommand* arqCommand =
+        dynamic_cast<wns::ldk::arq::ARQCommand*>(arq_->getCommand( compound->getCommandPool() ) );
+    assure( arqCommand, "Command is not of type ARQCommand" );
+
+    return arqCommand->isACK();
+}
+
+void ACKSwitch::doSendData( const wns::ldk::CompoundPtr& compound )
+{
+    if ( !aggregate_ || !isACK( compound ) )
+    {
+        wns::ldk::Processor<ACKSwitch>::doSendData( compound );
+        return;
+    }
+
+    ConnectionIdentifier::CID originalCID =
+        classifier_->getCommand( compound->getCommandPool() )->peer.id;
+    ConnectionIdentifierPtr basicConnection =
+        connectionManager_->getBasicConnectionFor( originalCID );
+
+    AckSwitchCommand::ACKs& acks = pending_[basicConnection->getID()];
+
+    if ( cumulative_ )
+    {
+        // the newer ACK acknowledges everything the pending one did
+        for ( AckSwitchCommand::ACKs::iterator it = acks.begin();
+              it != acks.end();
+              ++it )
+        {
+            if ( it->originalCID == originalCID )
+            {
+                acks.erase( it );
+                break;
+            }
+        }
+    }
+    acks.push_back( AckSwitchCommand::AggregatedACK( originalCID, compound ) );
+
+    LOG_INFO( "ACKSwitch: queueing outgoing ACK from CID ", originalCID,
+              " for basic CID ", basicConnection->getID() );
+}
+
+bool ACKSwitch::doIsAccepting( const wns::ldk::CompoundPtr& compound ) const
+{
+    // ACKs wait in pending_ until the lower FU accepts the aggregate
+    if ( aggregate_ && isACK( compound ) )
+        return true;
+
+    return wns::ldk::Processor<ACKSwitch>::doIsAccepting( compound );
+}
+
+void ACKSwitch::doWakeup()
+{
+    if ( blocked_ )
+        flush();
+
+    wns::ldk::Processor<ACKSwitch>::doWakeup();
+}
+
+void ACKSwitch::flush()
+{
+    blocked_ = false;
+
+    PendingACKs::iterator it = pending_.begin();
+    while ( it != pending_.end() )
+    {
+        wns::ldk::CompoundPtr aggregate(
+            new wns::ldk::Compound( getFUN()->getProxy()->createCommandPool() ) );
+
+        classifier_->activateCommand( aggregate->getCommandPool() )->peer.id = it->first;
+
+        AckSwitchCommand* command = activateCommand( aggregate->getCommandPool() );
+        command->peer.originalCID = it->first;
+        command->peer.acks = it->second;
+
+        if ( !getConnector()->hasAcceptor( aggregate ) )
+        {
+            // retried on the next wakeup
+            blocked_ = true;
+            ++it;
+            continue;
+        }
+
+        LOG_INFO( "ACKSwitch: sending ", it->second.size(),
+                  " aggregated ACKs on basic CID ", it->first );
+
+        pending_.erase( it++ );
+        getConnector()->getAcceptor( aggregate )->sendData( aggregate );
+    }
+}
+
+void ACKSwitch::doOnData( const wns::ldk::CompoundPtr& compound )
+{
+    if ( getFUN()->getProxy()->commandIsActivated( compound->getCommandPool(), this ) )
+    {
+        AckSwitchCommand* switchCommand = getCommand( compound->getCommandPool() );
+
+        if ( !switchCommand->peer.acks.empty() )
+        {
+            for ( AckSwitchCommand::ACKs::const_iterator it = switchCommand->peer.acks.begin();
+                  it != switchCommand->peer.acks.end();
+                  ++it )
+            {
+                // the ACK of the sender must not be modified
+                wns::ldk::CompoundPtr ack = it->ack->copy();
+                classifier_->getCommand( ack->getCommandPool() )->peer.id = it->originalCID;
+
+                LOG_INFO( "ACKSwitch: delivering aggregated ACK from basic CID ",
+                          switchCommand->peer.originalCID, " to data CID ",
+                          it->originalCID );
+
+                getDeliverer()->getAcceptor( ack )->onData( ack );
+            }
+            return;
+        }
+    }
+
+    wns::ldk::Processor<ACKSwitch>::doOnData( compound );
+}
+
+void ACKSwitch::calculateSizes( const wns::ldk::CommandPool* commandPool,
+                                Bit& commandPoolSize, Bit& dataSize ) const
+{
+    getFUN()->getProxy()->calculateSizes( commandPool, commandPoolSize, dataSize, this );
+
+    if ( getFUN()->getProxy()->commandIsActivated( commandPool, this ) )
+        commandPoolSize += getAggregatedSize( getCommand( commandPool )->peer.acks );
+}
+
+Bit ACKSwitch::getAggregatedSize( const AckSwitchCommand::ACKs& acks ) const
+{
+    if ( acks.empty() )
+        return 0;
+
+    // ACKs per connection
+    std::map<ConnectionIdentifier::CID, int> connections;
+    for ( AckSwitchCommand::ACKs::const_iterator it = acks.begin();
+          it != acks.end();
+          ++it )
+        ++connections[it->originalCID];
+
+    Bit size = headerSize_;
+    for ( std::map<ConnectionIdentifier::CID, int>::const_iterator it = connections.begin();
+          it != connections.end();
+          ++it )
+    {
+        // one sequence number per connection, plus one bit per ACK
+        // of the bitmap
+        size += cidSize_ + snSize_;
+        if ( !cumulative_ )
+            size += it->second;
+    }
+    return size;
+}
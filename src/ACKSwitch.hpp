@@ -42,8 +42,13 @@
 #include <WNS/ldk/FunctionalUnit.hpp>
 #include <WNS/ldk/Command.hpp>
 #include <WNS/ldk/Classifier.hpp>
+#include <WNS/ldk/fcf/NewFrameProviderObserver.hpp>
+#include <WNS/simulator/Bit.hpp>
 #include <WIMAC/ConnectionIdentifier.hpp>
 
+#include <map>
+#include <vector>
+
 namespace wns { namespace ldk { namespace arq {
     class ARQ;
 }}}
@@ -61,8 +66,29 @@ namespace service {
             : public wns::ldk::Command
     {
     public:
+        /**
+         * \brief One ACK carried by an aggregated ACK compound.
+         */
+        struct AggregatedACK
+        {
+            AggregatedACK( ConnectionIdentifier::CID _originalCID,
+                           const wns::ldk::CompoundPtr& _ack ) :
+                originalCID(_originalCID),
+                ack(_ack)
+            {}
+
+            ConnectionIdentifier::CID originalCID;
+            wns::ldk::CompoundPtr ack;
+        };
+        typedef std::vector<AggregatedACK> ACKs;
+
         struct {
             ConnectionIdentifier::CID originalCID;
+            /**
+             * \brief Empty unless the compound merges the ACKs for one
+             * peer.
+             */
+            ACKs acks;
         } peer;
 
         struct {
@@ -74,6 +100,13 @@ namespace service {
 
     /*
      * \brief Switches ARQ ACKs to the control connection of an associated SS.
+     *
+     * With an aggregation configured, the ACKs sent to one basic
+     * connection during a frame are merged into a single compound at the
+     * start of the next frame and split up again on the receiving side.
+     * In "cumulative" mode a newer ACK of a connection replaces the
+     * pending one, which is only valid for an ARQ with cumulative ACKs.
+     * In "bitmap" mode all ACKs are kept and acknowledged by one bit each.
      */
     class ACKSwitch :
             public wns::ldk::CommandTypeSpecifier<AckSwitchCommand>,
@@ -81,7 +114,8 @@ namespace service {
             public wns::ldk::HasReceptor<>,
             public wns::ldk::HasDeliverer<>,
             public wns::ldk::Processor<ACKSwitch>,
-            public wns::Cloneable<ACKSwitch>
+            public wns::Cloneable<ACKSwitch>,
+            public wns::ldk::fcf::NewFrameObserver
     {
     public:
         /**
@@ -104,7 +138,68 @@ namespace service {
 
         void onFUNCreated();
 
+        /**
+         * \brief Send the ACKs aggregated during the last frame.
+         */
+        void messageNewFrame();
+
+        /**
+         * \brief True if ACKs wait for the next frame start. Keeps
+         * TimingControl from skipping the frame as idle.
+         */
+        bool hasPendingACKs() const { return !pending_.empty(); }
+
+        void
+        calculateSizes( const wns::ldk::CommandPool* commandPool,
+                        Bit& commandPoolSize, Bit& dataSize ) const;
+
     private:
+        virtual void
+        doSendData( const wns::ldk::CompoundPtr& compound );
+
+        virtual void
+        doOnData( const wns::ldk::CompoundPtr& compound );
+
+        virtual bool
+        doIsAccepting( const wns::ldk::CompoundPtr& compound ) const;
+
+        virtual void
+        doWakeup();
+
+        bool
+        isACK( const wns::ldk::CompoundPtr& compound ) const;
+
+        /**
+         * \brief Send one aggregated ACK compound per basic connection.
+         */
+        void
+        flush();
+
+        Bit
+        getAggregatedSize( const AckSwitchCommand::ACKs& acks ) const;
+
+        bool aggregate_;
+        bool cumulative_;
+        Bit headerSize_;
+        Bit cidSize_;
+        Bit snSize_;
+
+        /**
+         * \brief Empty if the owner calls messageNewFrame itself
+         */
+        std::string frameBuilderName_;
+
+        /**
+         * \brief The ACKs waiting for aggregation, by basic CID
+         */
+        typedef std::map<ConnectionIdentifier::CID, AckSwitchCommand::ACKs> PendingACKs;
+        PendingACKs pending_;
+
+        /**
+         * \brief A flush found the lower FU blocked, retried on wakeup
+         */
+        bool blocked_;
+
         // friends
         wns::ldk::arq::ARQ* arq_;
         wns::ldk::CommandTypeSpecifier< wns::ldk::ClassifierCommand >* classifier_;
@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/BufferOccupancy.hpp>
+#include <WIMAC/Component.hpp>
+#include <WIMAC/Logger.hpp>
+
+#include <WNS/ldk/fun/FUN.hpp>
+#include <WNS/ldk/fun/Main.hpp>
+#include <WNS/ldk/Layer.hpp>
+
+
+STATIC_FACTORY_REGISTER_WITH_CREATOR(
+    wimac::BufferOccupancy,
+    wns::ldk::FunctionalUnit,
+    "wimac.BufferOccupancy",
+    wns::ldk::FUNConfigCreator);
+
+using namespace wimac;
+
+BufferOccupancy::BufferOccupancy(wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config) :
+    wns::ldk::CommandTypeSpecifier<>(fun),
+    wns::ldk::HasConnector<>(),
+    wns::ldk::HasReceptor<>(),
+    wns::ldk::HasDeliverer<>(),
+    wns::ldk::Processor<BufferOccupancy>(),
+    enqueue_(config.get<std::string>("mode") == "enqueue"),
+    sizeInBits_(config.get<std::string>("sizeUnit") == "Bit"),
+    bufferName_(config.get<std::string>("buffer")),
+    classifierName_(config.get<std::string>("classifier")),
+    component_(NULL),
+    buffer_(NULL),
+    classifier_(NULL)
+{
+    assure(enqueue_ || config.get<std::string>("mode") == "dequeue",
+           "BufferOccupancy: mode must be either \"enqueue\" or \"dequeue\"");
+}
+
+void
+BufferOccupancy::onFUNCreated()
+{
+    // We live inside the sub FUN of the buffer group, the classifier
+    // lives in the main FUN of the Component
+    component_ = dynamic_cast<Component*>(getFUN()->getLayer());
+    assure(component_, "BufferOccupancy can only be used in a wimac::Component");
+
+    classifier_ = component_->getFUN()->
+        findFriend<wns::ldk::CommandTypeSpecifier<wns::ldk::ClassifierCommand>*>(classifierName_);
+    assure(classifier_, "classifier not found in FUN");
+
+    buffer_ = getFUN()->findFriend<wns::ldk::buffer::Buffer*>(bufferName_);
+    assure(buffer_, "buffer not found in FUN");
+}
+
+void
+BufferOccupancy::doSendData(const wns::ldk::CompoundPtr& compound)
+{
+    if (!enqueue_)
+    {
+        wns::ldk::Processor<BufferOccupancy>::doSendData(compound);
+        return;
+    }
+
+    ConnectionIdentifier::CID cid =
+        classifier_->getCommand(compound->getCommandPool())->peer.id;
+    Bit bits = compound->getLengthInBits();
+
+    // Nothing is in transit here, so an empty buffer with a non-empty
+    // table means the buffer has been reset in between
+    if (buffer_->getSize() == 0 && getCounted(cid) > 0)
+    {
+        LOG_TRACE(getFUN()->getName(), ": buffer for CID ", cid,
+                  " has been emptied, resetting its occupancy");
+        component_->clearQueueOccupancy(cid);
+    }
+
+    // Count before forwarding, the buffer may pass the compound on to the
+    // dequeue instance right away
+    component_->increaseQueueOccupancy(cid, bits);
+
+    wns::ldk::Processor<BufferOccupancy>::doSendData(compound);
+
+    if (getCounted(cid) > buffer_->getSize())
+    {
+        LOG_TRACE(getFUN()->getName(), ": buffer for CID ", cid,
+                  " dropped the compound, it is not counted");
+        component_->decreaseQueueOccupancy(cid, bits);
+    }
+}
+
+unsigned long int
+BufferOccupancy::getCounted(ConnectionIdentifier::CID cid) const
+{
+    const Component::QueueOccupancy& occupancy = component_->getQueueOccupancy(cid);
+    return sizeInBits_ ? occupancy.bits : occupancy.pdus;
+}
+
+void
+BufferOccupancy::processOutgoing(const wns::ldk::CompoundPtr& compound)
+{
+    // The enqueue instance counts in doSendData
+    if (enqueue_)
+        return;
+
+    ConnectionIdentifier::CID cid =
+        classifier_->getCommand(compound->getCommandPool())->peer.id;
+
+    component_->decreaseQueueOccupancy(cid, compound->getLengthInBits());
+}
+
+void
+BufferOccupancy::processIncoming(const wns::ldk::CompoundPtr&)
+{
+}
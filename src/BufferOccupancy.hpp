@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_BUFFEROCCUPANCY_HPP
+#define WIMAC_BUFFEROCCUPANCY_HPP
+
+#include <WNS/ldk/ldk.hpp>
+
+#include <WNS/Cloneable.hpp>
+#include <WNS/ldk/CommandTypeSpecifier.hpp>
+#include <WNS/ldk/HasDeliverer.hpp>
+#include <WNS/ldk/HasConnector.hpp>
+#include <WNS/ldk/HasReceptor.hpp>
+#include <WNS/ldk/Processor.hpp>
+#include <WNS/ldk/Classifier.hpp>
+#include <WNS/ldk/buffer/Buffer.hpp>
+#include <WNS/simulator/Bit.hpp>
+
+#include <WIMAC/ConnectionIdentifier.hpp>
+
+namespace wimac {
+
+    class Component;
+
+    /**
+     * @brief Reports compounds entering or leaving a buffer to the
+     * occupancy table of the Component.
+     *
+     * Two instances enclose the per-CID buffer of the buffer group: the
+     * one above the buffer (mode "enqueue") counts compounds entering,
+     * the one below (mode "dequeue") counts compounds leaving it. The
+     * enqueue instance counts a compound before handing it to the buffer
+     * and reads the size of the buffer afterwards, so compounds that the
+     * buffer drops are taken out of the table again.
+     */
+    class BufferOccupancy :
+        public wns::ldk::CommandTypeSpecifier<>,
+        public wns::ldk::HasConnector<>,
+        public wns::ldk::HasReceptor<>,
+        public wns::ldk::HasDeliverer<>,
+        public wns::ldk::Processor<BufferOccupancy>,
+        public wns::Cloneable<BufferOccupancy>
+    {
+    public:
+        BufferOccupancy(wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config);
+
+        void processIncoming(const wns::ldk::CompoundPtr& compound);
+
+        void processOutgoing(const wns::ldk::CompoundPtr& compound);
+
+        void onFUNCreated();
+
+    private:
+        virtual void
+        doSendData(const wns::ldk::CompoundPtr& compound);
+
+        /**
+         * @brief Occupancy of the CID in the size unit of the buffer
+         */
+        unsigned long int
+        getCounted(ConnectionIdentifier::CID cid) const;
+
+        bool enqueue_;
+        bool sizeInBits_;
+
+        std::string bufferName_;
+        std::string classifierName_;
+
+        // friends
+        Component* component_;
+        wns::ldk::buffer::Buffer* buffer_;
+        wns::ldk::CommandTypeSpecifier<wns::ldk::ClassifierCommand>* classifier_;
+    };
+}
+
+#endif
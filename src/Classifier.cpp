@@ -120,6 +120,10 @@ ConnectionClassifier::classifyIncoming( const wns::ldk::CompoundPtr& compound )
     LOG_INFO( getFUN()->getLayer()->getName(), ": classify incomming compound.   CID: ",
               command->peer.id, " to destMACAdr: ", ucCommand->peer.targetMACAddress );
 
+    // Broadcasts have no registered ConnectionIdentifier
+    if( command->peer.id == ConnectionIdentifier::BroadcastCID )
+        return command->peer.id;
+
     ConnectionIdentifier::Ptr ci
         ( friends_.connectionManager->getConnectionWithID(command->peer.id) );
 
@@ -147,6 +151,13 @@ ConnectionClassifier::classifyOutgoing( const wns::ldk::CompoundPtr& compound )
     UpperCommand* ucCommand =
         friends_.upperConvergence->getCommand(compound->getCommandPool());
 
+    if( isBroadcast(ucCommand->peer.targetMACAddress) )
+    {
+        LOG_INFO( getFUN()->getName(), ": classify outgoing broadcast Compound to CID: ",
+                  ConnectionIdentifier::BroadcastCID );
+        return ConnectionIdentifier::BroadcastCID;
+    }
+
     ConnectionIdentifiers cis =
         friends_.connectionManager->getOutgoingDataConnections(
             ucCommand->peer.targetMACAddress.getInteger(),
@@ -181,6 +192,9 @@ ConnectionClassifier::doIsAccepting(const wns::ldk::CompoundPtr& compound) const
 
     UpperCommand* ucCommand = friends_.upperConvergence->getCommand(compound->getCommandPool());
 
+    if( isBroadcast(ucCommand->peer.targetMACAddress) )
+        return getConnector()->hasAcceptor(compound);
+
     // try to get ConnectionIdentifier for this compound
     ConnectionIdentifiers cis =
         friends_.connectionManager->getOutgoingDataConnections(
@@ -207,3 +221,11 @@ ConnectionClassifier::doIsAccepting(const wns::ldk::CompoundPtr& compound) const
     return false;
 }
 
+
+bool
+ConnectionClassifier::isBroadcast(const wns::service::dll::UnicastAddress& target) const
+{
+    // Only the base station sends broadcasts to its cell
+    return !target.isValid()
+        && friends_.component->getStationType() == wns::service::dll::StationTypes::AP();
+}
@@ -39,6 +39,7 @@
 #include <WNS/Cloneable.hpp>
 
 #include <WNS/ldk/Classifier.hpp>
+#include <WNS/service/dll/Address.hpp>
 
 
 namespace wns {
@@ -108,6 +109,13 @@ namespace wimac {
         void
         onFUNCreated();
 
+        /**
+         * @brief True if the target address addresses the whole cell and
+         * the compound has to be sent on the broadcast CID.
+         */
+        bool
+        isBroadcast(const wns::service::dll::UnicastAddress& target) const;
+
         struct {
             UpperConvergence* upperConvergence;
             service::ConnectionManager* connectionManager;
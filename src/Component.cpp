@@ -31,19 +31,19 @@
 
 #include <boost/bind.hpp>
 
+#include <WNS/Observer.hpp>
 #include <WNS/rng/RNGen.hpp>
 #include <WNS/ldk/fcf/FrameBuilder.hpp>
 #include <WNS/ldk/buffer/Buffer.hpp>
 #include <WNS/ldk/fun/Main.hpp>
 #include <WNS/ldk/utils.hpp>
-#include <WNS/ldk/Group.hpp>
-#include <WNS/ldk/FlowSeparator.hpp>
 #include <WNS/service/phy/ofdma/Handler.hpp>
 #include <WNS/service/phy/ofdma/DataTransmission.hpp>
 #include <WNS/service/dll/StationTypes.hpp>
 
-#include <WIMAC/ConnectionKey.hpp>
+#include <WIMAC/ErrorModelling.hpp>
 #include <WIMAC/Logger.hpp>
+#include <WIMAC/PhyModeTable.hpp>
 #include <WIMAC/PhyUser.hpp>
 #include <WIMAC/services/ConnectionManager.hpp>
 #include <WIMAC/StationManager.hpp>
@@ -59,11 +59,47 @@ STATIC_FACTORY_REGISTER_WITH_CREATOR(Component,
                                      wns::node::component::ConfigCreator);
 
 
+/**
+ * @brief Clears the queue occupancy of a connection once it is deleted.
+ *
+ * Lives in the translation unit since the ConnectionManager header
+ * depends on the Component.
+ */
+class Component::ConnectionObserver :
+    public wns::Observer<service::ConnectionDeletedNotification>
+{
+public:
+    ConnectionObserver(Component* component, service::ConnectionManager* connectionManager) :
+        component_(component),
+        connectionManager_(connectionManager)
+    {
+        startObserving(connectionManager_);
+    }
+
+    virtual void
+    notifyAboutConnectionDeleted(const ConnectionIdentifier ci)
+    {
+        // the connection is only changed, its buffer is kept
+        if (connectionManager_->isChanging())
+            return;
+
+        component_->clearQueueOccupancy(ci.getID());
+    }
+
+private:
+    Component* component_;
+    service::ConnectionManager* connectionManager_;
+};
+
 Component::Component(wns::node::Interface* node, const wns::pyconfig::View& config) :
     wns::node::component::Component(node, config),
     stationType_(wns::service::dll::StationTypes::fromString(config.get<std::string>("stationType"))),
     id_(config.get<unsigned int>("stationID")),
-    address_(config.get<wns::service::dll::UnicastAddress>("address"))
+    address_(config.get<wns::service::dll::UnicastAddress>("address")),
+    queueOccupancy_(),
+    totalQueueOccupancy_(),
+    connectionObserver_(NULL),
+    upRelayInject_(NULL)
 {
     LOG_INFO( "Creating station ", node->getName(), " with station ID ", id_,
               " and station type ", wns::service::dll::StationTypes::toString(stationType_) );
@@ -150,6 +186,12 @@ Component::Component(wns::node::Interface* node, const wns::pyconfig::View& conf
             config.get<std::string>("upperConvergenceName"),
             "MAC.StationType",
             &wimac::Component::getStationType));
+    getNode()->getContextProviderCollection().
+        addProvider(wns::probe::bus::contextprovider::Callback
+                    ("MAC.QueuedPDUs", boost::bind(&wimac::Component::getTotalQueuedPDUs, this ) ) );
+    getNode()->getContextProviderCollection().
+        addProvider(wns::probe::bus::contextprovider::Callback
+                    ("MAC.QueuedBits", boost::bind(&wimac::Component::getTotalQueuedBits, this ) ) );
 
     // global station registry
     TheStationManager::getInstance()->registerStation(id_, address_, this);
@@ -159,6 +201,11 @@ Component::Component(wns::node::Interface* node, const wns::pyconfig::View& conf
 
 }
 
+Component::~Component()
+{
+    delete connectionObserver_;
+}
+
 void
 Component::doStartup()
 {
@@ -236,6 +283,12 @@ Component::onNodeCreated()
     getMSR()->onMSRCreated();
     getCSR()->onCSRCreated();
 
+    connectionObserver_ = new ConnectionObserver(
+        this, getManagementService<service::ConnectionManager>("connectionManager"));
+
+    if (getFUN()->knowsFunctionalUnit("upRelayInject"))
+        upRelayInject_ = getFUN()->findFriend<wns::ldk::buffer::Buffer*>("upRelayInject");
+
     // Start the Framebuilder and set it to pause state for synchronizing the
     // periodically event of all stations. 
     wns::ldk::fcf::FrameBuilder* frameBuilder =
@@ -251,11 +304,18 @@ Component::onWorldCreated()
 void
 Component::onShutdown()
 {
+    // leave the FrameClock, it outlives this simulation
+    getFUN()->findFriend<wns::ldk::fcf::FrameBuilder*>("frameBuilder")->stop();
+
+    // the shared tables refer to PhyModeMappers of this simulation
+    PhyModeTable::clearTables();
+    ErrorModelling::clearSharedTables();
+
     getFUN()->onShutdown();
 }
 
 int
-Component::getNumberOfQueuedPDUs(ConnectionIdentifiers cis)
+Component::getNumberOfQueuedPDUs(const ConnectionIdentifiers& cis) const
 {
     int queuedPDUs = 0;
     for(ConnectionIdentifiers::const_iterator conn = cis.begin();
@@ -264,25 +324,12 @@ Component::getNumberOfQueuedPDUs(ConnectionIdentifiers cis)
     {
         assure((*conn)->direction_ != ConnectionIdentifier::Downlink,
                "Component::getNumberOfQueuedPDUs(...) works for uplink PDUs only");
-        wns::ldk::FlowSeparator* bufferSep =
-            getFUN()->findFriend<wns::ldk::FlowSeparator*>("bufferSep");
-        wns::ldk::ConstKeyPtr key(new ConnectionKey((*conn)->cid_));
-        wns::ldk::Group* group =
-            dynamic_cast<wns::ldk::Group*>(bufferSep->getInstance(key));
-        if(group)
-        {
-            wns::ldk::buffer::Buffer* buffer =
-                group->getSubFUN()->findFriend<wns::ldk::buffer::Buffer*>("buffer");
-            assure(buffer, "Cannot find buffer in subFUN");
-            queuedPDUs += buffer->getSize();
-        }
+        queuedPDUs += getQueueOccupancy((*conn)->cid_).pdus;
     }
-    if (getFUN()->knowsFunctionalUnit("upRelayInject"))
+    if (upRelayInject_ != NULL)
     {
-        wns::ldk::buffer::Buffer* relayInject =
-            getFUN()->findFriend<wns::ldk::buffer::Buffer*>("upRelayInject");
-        queuedPDUs += relayInject->getSize();
-        LOG_INFO("Added ", relayInject->getSize(),
+        queuedPDUs += upRelayInject_->getSize();
+        LOG_INFO("Added ", upRelayInject_->getSize(),
                  " PDUs to the number of total PDUs waiting for beeing transmitted");
     }
     LOG_INFO( getName(), " with station ID ", id_,
@@ -291,6 +338,79 @@ Component::getNumberOfQueuedPDUs(ConnectionIdentifiers cis)
     return queuedPDUs;
 }
 
+const Component::QueueOccupancy&
+Component::getQueueOccupancy(ConnectionIdentifier::CID cid) const
+{
+    static const QueueOccupancy empty;
+
+    QueueOccupancyMap::const_iterator it = queueOccupancy_.find(cid);
+    if (it == queueOccupancy_.end())
+        return empty;
+
+    return it->second;
+}
+
+void
+Component::increaseQueueOccupancy(ConnectionIdentifier::CID cid, Bit bits)
+{
+    QueueOccupancy& occupancy = queueOccupancy_[cid];
+    occupancy.pdus += 1;
+    occupancy.bits += bits;
+
+    totalQueueOccupancy_.pdus += 1;
+    totalQueueOccupancy_.bits += bits;
+}
+
+void
+Component::decreaseQueueOccupancy(ConnectionIdentifier::CID cid, Bit bits)
+{
+    QueueOccupancyMap::iterator it = queueOccupancy_.find(cid);
+    if (it == queueOccupancy_.end())
+    {
+        // cleared by clearQueueOccupancy, the compound was queued before
+        LOG_TRACE(getName(), ": CID ", cid, " has no queue occupancy, ignoring dequeue");
+        return;
+    }
+    assure(it->second.pdus > 0,
+           "Component::decreaseQueueOccupancy: buffer of CID is already empty");
+
+    it->second.pdus -= 1;
+    it->second.bits -= bits;
+
+    totalQueueOccupancy_.pdus -= 1;
+    totalQueueOccupancy_.bits -= bits;
+
+    if (it->second.pdus == 0)
+        queueOccupancy_.erase(it);
+}
+
+void
+Component::clearQueueOccupancy(ConnectionIdentifier::CID cid)
+{
+    QueueOccupancyMap::iterator it = queueOccupancy_.find(cid);
+    if (it == queueOccupancy_.end())
+        return;
+
+    LOG_INFO(getName(), ": clearing queue occupancy of CID ", cid,
+             " (", it->second.pdus, " PDUs)");
+
+    totalQueueOccupancy_.pdus -= it->second.pdus;
+    totalQueueOccupancy_.bits -= it->second.bits;
+    queueOccupancy_.erase(it);
+}
+
+int
+Component::getTotalQueuedPDUs() const
+{
+    return totalQueueOccupancy_.pdus;
+}
+
+Bit
+Component::getTotalQueuedBits() const
+{
+    return totalQueueOccupancy_.bits;
+}
+
 void
 Component::doVisit(wns::probe::bus::IContext& context) const
 {
@@ -33,9 +33,12 @@
 #include <WNS/probe/bus/ContextProviderCollection.hpp>
 #include <WNS/service/dll/DataTransmission.hpp>
 #include <WNS/ldk/fun/Main.hpp>
+#include <WNS/simulator/Bit.hpp>
 
 #include <WIMAC/ConnectionIdentifier.hpp>
 
+#include <map>
+
 
 namespace wimac {
 
@@ -90,8 +93,25 @@ namespace wimac {
         typedef ConnectionIdentifier::StationID StationID;
         typedef ConnectionIdentifier::QoSCategory QoSCategory;
 
+        /**
+         * @brief Number of PDUs and bits waiting in the buffer of a
+         * connection.
+         */
+        struct QueueOccupancy
+        {
+            QueueOccupancy() :
+                pdus(0),
+                bits(0)
+            {}
+
+            int pdus;
+            Bit bits;
+        };
+
         Component(wns::node::Interface*, const wns::pyconfig::View&);
 
+        virtual ~Component();
+
         std::string
         getName() const;
 
@@ -141,9 +161,42 @@ namespace wimac {
         /**
          * @brief Used by class PseudoBWreqGenerator for BWreq shortcut.
          *
-         * @todo Replace getNumberOfQueuedPDUs with a better solution.
+         * Reads the occupancy table, which is kept up to date by the
+         * BufferOccupancy FUs around the buffers.
+         */
+        int getNumberOfQueuedPDUs(const ConnectionIdentifiers& cis) const;
+
+        /**
+         * @brief Occupancy of the buffer of the given connection.
+         */
+        const QueueOccupancy&
+        getQueueOccupancy(ConnectionIdentifier::CID cid) const;
+
+        /** @brief Called by the BufferOccupancy FU on enqueue */
+        void
+        increaseQueueOccupancy(ConnectionIdentifier::CID cid, Bit bits);
+
+        /** @brief Called by the BufferOccupancy FU on dequeue */
+        void
+        decreaseQueueOccupancy(ConnectionIdentifier::CID cid, Bit bits);
+
+        /**
+         * @brief Forget the occupancy of a connection.
+         *
+         * Called when the connection is deleted or its buffer has been
+         * reset. Compounds of the connection that still leave a buffer
+         * afterwards are not counted anymore.
          */
-        int getNumberOfQueuedPDUs(ConnectionIdentifiers cis);
+        void
+        clearQueueOccupancy(ConnectionIdentifier::CID cid);
+
+        /** @brief Number of PDUs in all buffers of this station */
+        int
+        getTotalQueuedPDUs() const;
+
+        /** @brief Number of bits in all buffers of this station */
+        Bit
+        getTotalQueuedBits() const;
 
         // ComponentInterface
         virtual void onNodeCreated();
@@ -195,6 +248,21 @@ namespace wimac {
         unsigned int ring_;
 
         wns::probe::bus::ContextProviderCollection contextProviders_;
+
+        typedef std::map<ConnectionIdentifier::CID, QueueOccupancy> QueueOccupancyMap;
+        QueueOccupancyMap queueOccupancy_;
+        QueueOccupancy totalQueueOccupancy_;
+
+        /**
+         * @brief Clears the occupancy of deleted connections
+         */
+        class ConnectionObserver;
+        ConnectionObserver* connectionObserver_;
+
+        /**
+         * @brief Relay inject buffer, NULL if the station is no relay
+         */
+        wns::ldk::buffer::Buffer* upRelayInject_;
     };
 }
 
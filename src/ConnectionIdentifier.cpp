@@ -29,6 +29,8 @@
 
 using namespace wimac;
 
+const ConnectionIdentifier::CID ConnectionIdentifier::BroadcastCID = 0xFFFF;
+
 ConnectionIdentifier::ConnectionIdentifier () :
     baseStation_(0),
     cid_(-1),
@@ -97,6 +97,15 @@ namespace wimac {
 
         typedef int Frames;
 
+        /**
+         * @brief CID reserved for the broadcast traffic of a cell.
+         *
+         * No ConnectionIdentifier is registered for it, compounds
+         * classified with it are scheduled by the broadcast path of the
+         * DL scheduler.
+         */
+        static const CID BroadcastCID;
+
         ConnectionIdentifier(StationID baseStation,
                               StationID subscriberStation,
                               StationID remoteStation,
@@ -31,9 +31,84 @@
 
 #include <WIMAC/ErrorModelling.hpp>
 #include <WIMAC/CIRProvider.hpp>
+#include <WIMAC/Component.hpp>
+#include <WIMAC/frame/DataCollector.hpp>
+#include <WIMAC/services/LinkAdaptation.hpp>
+
+#include <WNS/probe/bus/ContextProviderCollection.hpp>
+#include <WNS/probe/bus/utils.hpp>
+
+#include <map>
+#include <sstream>
 
 using namespace wimac;
 
+namespace {
+
+    /**
+     * @brief Exact SINR -> MIB -> PER mapping of the PhyModes of a mapper
+     */
+    class PhyModeMapping :
+        public PERTable::MappingInterface
+    {
+    public:
+        PhyModeMapping(const wns::service::phy::phymode::PhyModeMapperInterface* mapper) :
+            mapper_(mapper)
+        {}
+
+        virtual int
+        getNumberOfPhyModes() const
+        {
+            return mapper_->getPhyModeCount();
+        }
+
+        virtual double
+        getPER(int phyMode, double sinr, unsigned int blockSize) const
+        {
+            wns::service::phy::phymode::PhyModeInterfacePtr mode =
+                mapper_->getPhyModeForIndex(phyMode);
+            return mode->getMI2PER(mode->getSINR2MIB(wns::Ratio::from_dB(sinr)), blockSize);
+        }
+
+    private:
+        const wns::service::phy::phymode::PhyModeMapperInterface* mapper_;
+    };
+
+    typedef std::map<std::pair<const wns::service::phy::phymode::PhyModeMapperInterface*, std::string>,
+                     PERTablePtr> PERTableMap;
+
+    PERTableMap&
+    getPERTables()
+    {
+        static PERTableMap tables;
+        return tables;
+    }
+
+    /**
+     * @brief Tables are expensive to build, so stations with the same
+     * mapper and configuration share them.
+     */
+    PERTablePtr
+    getSharedPERTable(const wns::service::phy::phymode::PhyModeMapperInterface* mapper,
+                      const wns::pyconfig::View& config)
+    {
+        std::stringstream key;
+        key << config.get<double>("minSINR") << ":"
+            << config.get<double>("maxSINR") << ":"
+            << config.get<double>("sinrResolution") << ":"
+            << config.get<int>("minBlockSize") << ":"
+            << config.get<int>("maxBlockSize") << ":"
+            << config.get<int>("blockSizeResolution") << ":"
+            << config.get<double>("maxError") << ":"
+            << config.get<int>("checkPoints");
+
+        PERTablePtr& table = getPERTables()[std::make_pair(mapper, key.str())];
+        if (table == PERTablePtr())
+            table = PERTablePtr(new PERTable(PhyModeMapping(mapper), config));
+        return table;
+    }
+}
+
 STATIC_FACTORY_REGISTER_WITH_CREATOR(
     wimac::ErrorModelling,
     wns::ldk::FunctionalUnit,
@@ -46,8 +121,44 @@ ErrorModelling::ErrorModelling(wns::ldk::fun::FUN* fun, const wns::pyconfig::Vie
     wns::ldk::Forwarding<ErrorModelling>(),
     CIRProviderName_(config.get<std::string>("cirProvider")),
     PHYModeProviderName_( config.get<std::string>("phyModeProvider")),
+    phyModeMapper_(NULL),
+    phyModeTable_(),
+    perTable_(),
+    earlyDecision_(!config.isNone("earlyDecision")),
     friends()
 {
+    friends.CIRProvider = NULL;
+    friends.PHYModeProvider = NULL;
+    friends.phyUser = NULL;
+    friends.layer = NULL;
+    friends.linkAdaptation = NULL;
+
+    if (!config.isNone("linkAdaptation"))
+        linkAdaptationName_ = config.get<std::string>("linkAdaptation");
+
+    if (!config.isNone("perTable"))
+    {
+        phyModeMapper_ = wns::service::phy::phymode::PhyModeMapperInterface::getPhyModeMapper(
+            config.getView("phyModeMapping"));
+        phyModeTable_ = PhyModeTable::getTable(phyModeMapper_, config.getView("phyModeTable"));
+        perTable_ = getSharedPERTable(phyModeMapper_, config.getView("perTable"));
+
+        LOG_INFO( getFUN()->getName(), ": using PER table, ",
+                  perTable_->getNumberOfExactCells(),
+                  " cells are evaluated exactly for maxError=", perTable_->getMaxError());
+    }
+
+    if (earlyDecision_)
+    {
+        wns::probe::bus::ContextProviderCollection cpc(
+            &fun->getLayer()->getContextProviderCollection());
+        lossRatio_ = wns::probe::bus::collector(
+            cpc, config.getView("earlyDecision"), "lossRatioProbeName");
+
+        wns::pyconfig::View earlyDecision = config.getView("earlyDecision");
+        for (int i = 0; i < earlyDecision.len("dataCollectors"); ++i)
+            dataCollectorNames_.push_back(earlyDecision.get<std::string>("dataCollectors", i));
+    }
 }
 
 void
@@ -62,24 +173,179 @@ ErrorModelling::processOutgoing(const wns::ldk::CompoundPtr& compound)
 void
 ErrorModelling::processIncoming(const wns::ldk::CompoundPtr& compound)
 {
-    wns::Ratio cir = dynamic_cast<CIRProviderCommand*>
-        (friends.CIRProvider->getCommand(compound->getCommandPool()))->getCIR();
+    ErrorModellingCommand* command = getCommand(compound->getCommandPool());
 
-    const wns::service::phy::phymode::PhyModeInterface*	phyModePtr = 
-        dynamic_cast<wimac::PhyModeProviderCommand*>(
-            friends.PHYModeProvider->getCommand(compound->getCommandPool()))
-                ->getPhyModePtr();
+    if (command->local.evaluated)
+    {
+        LOG_INFO( getFUN()->getName(), ": doOnData! PER=", command->local.per,
+                  " (batch)");
+        return;
+    }
 
-    int blocksize = compound->getLengthInBits();
-    double mib = phyModePtr->getSINR2MIB(cir);
-    double per = phyModePtr->getMI2PER(mib, blocksize); 
+    wns::Ratio cir;
+    const wns::service::phy::phymode::PhyModeInterface* phyModePtr;
+    getProviderValues(compound, cir, phyModePtr);
 
     //  Output
-    this->getCommand(compound->getCommandPool())->local.per = per;
+    command->local.per = getPER(*phyModePtr, cir, compound->getLengthInBits());
+    reportOutcome(compound, command->local.per);
 
     LOG_INFO( getFUN()->getName(),
               ": doOnData!  CIR=",cir.get_dB()," PHY Mode=", phyModePtr->getString(),
-              " ; PER=",getCommand( compound->getCommandPool() )->local.per);
+              " ; PER=",command->local.per);
+}
+
+void
+ErrorModelling::evaluate(const std::vector<wns::ldk::CompoundPtr>& compounds)
+{
+    std::size_t n = compounds.size();
+    if (n == 0)
+        return;
+
+    batch_.phyModes.resize(n);
+    batch_.phyModeIndices.resize(n);
+    batch_.sinrs.resize(n);
+    batch_.cirs.resize(n);
+    batch_.blockSizes.resize(n);
+    batch_.pers.resize(n);
+    batch_.found.assign(n, 0);
+
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        getProviderValues(compounds[k], batch_.cirs[k], batch_.phyModes[k]);
+        batch_.sinrs[k] = batch_.cirs[k].get_dB();
+        batch_.blockSizes[k] = compounds[k]->getLengthInBits();
+    }
+
+    if (perTable_ != PERTablePtr())
+    {
+        for (std::size_t k = 0; k < n; ++k)
+            batch_.phyModeIndices[k] = phyModeTable_->getIndex(*batch_.phyModes[k]);
+
+        perTable_->lookup(n, &batch_.phyModeIndices[0], &batch_.sinrs[0],
+                          &batch_.blockSizes[0], &batch_.pers[0], &batch_.found[0]);
+    }
+
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        if (!batch_.found[k])
+        {
+            const wns::service::phy::phymode::PhyModeInterface* phyMode = batch_.phyModes[k];
+            batch_.pers[k] = phyMode->getMI2PER(phyMode->getSINR2MIB(batch_.cirs[k]),
+                                                batch_.blockSizes[k]);
+        }
+
+        if (!getFUN()->getProxy()->commandIsActivated(compounds[k]->getCommandPool(), this))
+            continue;
+
+        ErrorModellingCommand* command = getCommand(compounds[k]->getCommandPool());
+        command->local.per = batch_.pers[k];
+        command->local.evaluated = true;
+
+        reportOutcome(compounds[k], command->local.per);
+    }
+
+    LOG_INFO( getFUN()->getName(), ": evaluated ", n, " compounds in a batch");
+}
+
+bool
+ErrorModelling::decidesEarly() const
+{
+    return earlyDecision_;
+}
+
+void
+ErrorModelling::decide(std::vector<wns::ldk::CompoundPtr>& compounds)
+{
+    std::size_t kept = 0;
+    for (std::size_t k = 0; k < compounds.size(); ++k)
+    {
+        // evaluate() skipped it, the CRC decides
+        if (!getFUN()->getProxy()->commandIsActivated(compounds[k]->getCommandPool(), this))
+        {
+            compounds[kept++] = compounds[k];
+            continue;
+        }
+
+        ErrorModellingCommand* command = getCommand(compounds[k]->getCommandPool());
+        assure(command->local.evaluated, "Early decision needs an evaluated compound");
+
+        if (uniform_() < command->local.per)
+        {
+            LOG_INFO( getFUN()->getName(), ": dropping compound with PER=",
+                      command->local.per, " early");
+            lossRatio_->put(compounds[k], 1.0);
+            continue;
+        }
+
+        command->local.decided = true;
+        compounds[kept++] = compounds[k];
+    }
+    compounds.resize(kept);
+}
+
+void
+ErrorModelling::reportOutcome(const wns::ldk::CompoundPtr& compound, double per)
+{
+    if (friends.linkAdaptation == NULL)
+        return;
+
+    PhyUserCommand* puCommand = friends.phyUser->getCommand(compound->getCommandPool());
+
+    // Broadcasts are sent with the most robust PhyMode anyway
+    if (!puCommand->peer.destination_)
+        return;
+
+    friends.linkAdaptation->storeOutcome(puCommand->peer.source_,
+                                         service::LinkAdaptation::Receive, per);
+
+    puCommand->magic.sourceComponent_
+        ->getManagementService<service::LinkAdaptation>(linkAdaptationName_)
+        ->storeOutcome(friends.layer->getNode(), service::LinkAdaptation::Transmit, per);
+}
+
+void
+ErrorModelling::getProviderValues(const wns::ldk::CompoundPtr& compound,
+                                  wns::Ratio& cir,
+                                  const wns::service::phy::phymode::PhyModeInterface*& phyMode) const
+{
+    if (friends.phyUser)
+    {
+        PhyUserCommand* puCommand =
+            friends.phyUser->getCommand(compound->getCommandPool());
+        cir = puCommand->getCIR();
+        phyMode = puCommand->getPhyModePtr();
+    }
+    else
+    {
+        cir = dynamic_cast<CIRProviderCommand*>
+            (friends.CIRProvider->getCommand(compound->getCommandPool()))->getCIR();
+
+        phyMode = dynamic_cast<wimac::PhyModeProviderCommand*>(
+            friends.PHYModeProvider->getCommand(compound->getCommandPool()))
+                ->getPhyModePtr();
+    }
+}
+
+double
+ErrorModelling::getPER(const wns::service::phy::phymode::PhyModeInterface& phyMode,
+                       const wns::Ratio& cir,
+                       unsigned int blocksize) const
+{
+    double per;
+
+    if (perTable_ != PERTablePtr()
+        && perTable_->lookup(phyModeTable_->getIndex(phyMode),
+                             cir.get_dB(), blocksize, per))
+        return per;
+
+    return phyMode.getMI2PER(phyMode.getSINR2MIB(cir), blocksize);
+}
+
+void
+ErrorModelling::clearSharedTables()
+{
+    getPERTables().clear();
 }
 
 void
@@ -93,6 +359,35 @@ ErrorModelling::onFUNCreated()
     assure(friends.PHYModeProvider,
            "ErrorModelling requires a PHYModeProvider friend with name '"
            + PHYModeProviderName_ + "' \n");
+
+    if (friends.CIRProvider == friends.PHYModeProvider)
+        friends.phyUser = dynamic_cast<PhyUser*>(friends.CIRProvider);
+
+    if (!linkAdaptationName_.empty())
+    {
+        friends.layer = dynamic_cast<Component*>(getFUN()->getLayer());
+        assure(friends.layer, "ErrorModelling must be part of wimac::Component");
+        assure(friends.phyUser, "Link adaptation needs the PhyUser as CIR and PhyMode provider");
+
+        friends.linkAdaptation = friends.layer
+            ->getManagementService<service::LinkAdaptation>(linkAdaptationName_);
+    }
+    // Without a batch evaluation nothing would ever be decided early
+    if (earlyDecision_)
+    {
+        bool batched = false;
+        for (std::vector<std::string>::const_iterator it = dataCollectorNames_.begin();
+             it != dataCollectorNames_.end() && !batched; ++it)
+        {
+            frame::DataCollector* dataCollector =
+                getFUN()->findFriend<frame::DataCollector*>(*it);
+            assure(dataCollector, *it + " is not a wimac::frame::DataCollector");
+
+            const std::string& name = dataCollector->getBatchErrorModellingName();
+            batched = !name.empty() && getFUN()->findFriend<ErrorModelling*>(name) == this;
+        }
+        assure(batched, "earlyDecision needs a DataCollector with batchErrorModelling set to this ErrorModelling");
+    }
 }
 
 
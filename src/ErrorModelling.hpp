@@ -37,12 +37,22 @@
 #include <WNS/ldk/ErrorRateProviderInterface.hpp>
 #include <WNS/pyconfig/View.hpp>
 #include <WNS/PowerRatio.hpp>
+#include <WNS/distribution/Uniform.hpp>
+#include <WNS/probe/bus/ContextCollector.hpp>
+
+#include <vector>
 
 #include <WIMAC/PhyUser.hpp>
+#include <WIMAC/PERTable.hpp>
+#include <WIMAC/PhyModeTable.hpp>
 #include <WIMAC/Logger.hpp>
 
 namespace wimac {
 
+    namespace service {
+        class LinkAdaptation;
+    }
+
     /**
      * @brief The Command of the ErrorModelling.
      */
@@ -55,15 +65,31 @@ namespace wimac {
         ErrorModellingCommand()
         {
             local.per = 1;
+            local.evaluated = false;
+            local.decided = false;
         }
 
+        /**
+         * @brief Zero if the outcome was already drawn, so the CRC passes
+         * the compound.
+         */
         virtual double getErrorRate() const
         {
-            return local.per;
+            return local.decided ? 0.0 : local.per;
         }
 
         struct {
             double per;
+            /**
+             * @brief Set if the PER was already computed in a batch before
+             * the compound reached the ErrorModelling.
+             */
+            bool evaluated;
+
+            /**
+             * @brief Set if the compound survived the early decision.
+             */
+            bool decided;
         } local;
         struct {} peer;
         struct {} magic;
@@ -75,6 +101,19 @@ namespace wimac {
      *
      * It maps the SINR for a PhyMode
      * to the Packet Error Rate (PER)
+     *
+     * If a perTable is configured, the PER is looked up in a table built at
+     * startup for the PhyModes of phyModeMapping. The table is shared by all
+     * stations using the same configuration.
+     *
+     * If linkAdaptation names a LinkAdaptation service, the PER of each
+     * unicast compound is reported to it as soft decoding outcome.
+     *
+     * With earlyDecision configured, the CRC outcome of batch evaluated
+     * compounds is drawn right away. Failed compounds are counted in the
+     * loss ratio probe of the CRC and dropped before they reach the upper
+     * FUs. One of the configured DataCollectors must evaluate its batches
+     * with this ErrorModelling.
      */
     class ErrorModelling :
         public wns::ldk::fu::Plain<ErrorModelling, ErrorModellingCommand>,
@@ -93,14 +132,80 @@ namespace wimac {
         virtual void
         onFUNCreated();
 
+        /**
+         * @brief Compute and store the PER of several received compounds
+         * at once.
+         *
+         * Used by the DataCollector for all compounds received at the same
+         * time. processIncoming then skips these compounds.
+         */
+        void
+        evaluate(const std::vector<wns::ldk::CompoundPtr>& compounds);
+
+        bool
+        decidesEarly() const;
+
+        /**
+         * @brief Draw the CRC outcome of evaluated compounds and remove
+         * the failed ones.
+         */
+        void
+        decide(std::vector<wns::ldk::CompoundPtr>& compounds);
+
+        /**
+         * @brief Forget the PER tables shared between stations
+         */
+        static void
+        clearSharedTables();
 
     private:
+        double
+        getPER(const wns::service::phy::phymode::PhyModeInterface& phyMode,
+               const wns::Ratio& cir,
+               unsigned int blocksize) const;
+
         std::string CIRProviderName_;
         std::string PHYModeProviderName_;
+        std::string linkAdaptationName_;
+
+        void
+        reportOutcome(const wns::ldk::CompoundPtr& compound, double per);
+
+        void
+        getProviderValues(const wns::ldk::CompoundPtr& compound,
+                          wns::Ratio& cir,
+                          const wns::service::phy::phymode::PhyModeInterface*& phyMode) const;
+
+        wns::service::phy::phymode::PhyModeMapperInterface* phyModeMapper_;
+        PhyModeTablePtr phyModeTable_;
+        PERTablePtr perTable_;
+
+        bool earlyDecision_;
+        std::vector<std::string> dataCollectorNames_;
+        wns::probe::bus::ContextCollectorPtr lossRatio_;
+        wns::distribution::StandardUniform uniform_;
+
+        // Batch buffers, kept to avoid reallocation
+        struct Batch {
+            std::vector<const wns::service::phy::phymode::PhyModeInterface*> phyModes;
+            std::vector<int> phyModeIndices;
+            std::vector<double> sinrs;
+            std::vector<wns::Ratio> cirs;
+            std::vector<unsigned int> blockSizes;
+            std::vector<double> pers;
+            std::vector<char> found;
+        } batch_;
 
         struct Friends {
             FunctionalUnit* CIRProvider;
             FunctionalUnit* PHYModeProvider;
+            /**
+             * @brief Set if both providers are the PhyUser, whose command
+             * is reached without cross casts.
+             */
+            PhyUser* phyUser;
+            Component* layer;
+            service::LinkAdaptation* linkAdaptation;
         } friends;
     };
 }
@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/PERTable.hpp>
+
+#include <WNS/Assure.hpp>
+
+#include <cmath>
+
+using namespace wimac;
+
+PERTable::PERTable(const MappingInterface& mapping, const wns::pyconfig::View& config) :
+    minSINR_(config.get<double>("minSINR")),
+    sinrResolution_(config.get<double>("sinrResolution")),
+    sinrPoints_(0),
+    minBlockSize_(config.get<int>("minBlockSize")),
+    blockSizeResolution_(config.get<int>("blockSizeResolution")),
+    blockSizePoints_(0),
+    maxError_(config.get<double>("maxError")),
+    values_(),
+    exact_()
+{
+    double maxSINR = config.get<double>("maxSINR");
+    int maxBlockSize = config.get<int>("maxBlockSize");
+    int checkPoints = config.get<int>("checkPoints");
+
+    assure(sinrResolution_ > 0.0, "sinrResolution must be positive");
+    assure(blockSizeResolution_ > 0.0, "blockSizeResolution must be positive");
+    assure(maxSINR > minSINR_, "maxSINR must be larger than minSINR");
+    assure(maxBlockSize > minBlockSize_, "maxBlockSize must be larger than minBlockSize");
+    assure(minBlockSize_ >= 0.0, "minBlockSize must not be negative");
+    assure(checkPoints >= 2, "checkPoints must be at least 2");
+
+    sinrPoints_ = int(std::floor((maxSINR - minSINR_) / sinrResolution_ + 0.5)) + 1;
+    blockSizePoints_ = int(std::floor((maxBlockSize - minBlockSize_) / blockSizeResolution_ + 0.5)) + 1;
+
+    int phyModes = mapping.getNumberOfPhyModes();
+
+    values_.resize(phyModes * sinrPoints_ * blockSizePoints_);
+    exact_.resize(phyModes * (sinrPoints_ - 1) * (blockSizePoints_ - 1), false);
+
+    for (int mode = 0; mode < phyModes; ++mode)
+    {
+        for (int i = 0; i < sinrPoints_; ++i)
+        {
+            for (int j = 0; j < blockSizePoints_; ++j)
+            {
+                values_[(mode * sinrPoints_ + i) * blockSizePoints_ + j] =
+                    mapping.getPER(mode,
+                                   minSINR_ + i * sinrResolution_,
+                                   (unsigned int)(minBlockSize_ + j * blockSizeResolution_));
+            }
+        }
+
+        for (int i = 0; i < sinrPoints_ - 1; ++i)
+        {
+            for (int j = 0; j < blockSizePoints_ - 1; ++j)
+            {
+                bool deviates = false;
+
+                for (int k = 0; k <= checkPoints && !deviates; ++k)
+                {
+                    for (int l = 0; l <= checkPoints && !deviates; ++l)
+                    {
+                        // the corners are the grid points themselves
+                        if ((k == 0 || k == checkPoints) && (l == 0 || l == checkPoints))
+                            continue;
+
+                        double fx = double(k) / checkPoints;
+                        double sinr = minSINR_ + (i + fx) * sinrResolution_;
+                        unsigned int blockSize = (unsigned int)(
+                            minBlockSize_ + (j + double(l) / checkPoints) * blockSizeResolution_ + 0.5);
+
+                        double fy = (blockSize - minBlockSize_) / blockSizeResolution_ - j;
+
+                        double exact = mapping.getPER(mode, sinr, blockSize);
+
+                        deviates = std::fabs(interpolate(mode, i, j, fx, fy) - exact) > maxError_;
+                    }
+                }
+
+                exact_[(mode * (sinrPoints_ - 1) + i) * (blockSizePoints_ - 1) + j] = deviates;
+            }
+        }
+    }
+}
+
+void
+PERTable::lookup(std::size_t n,
+                 const int* phyModes,
+                 const double* sinrs,
+                 const unsigned int* blockSizes,
+                 double* pers,
+                 char* found) const
+{
+    if (n == 0)
+        return;
+
+    x_.resize(n);
+    y_.resize(n);
+
+    double* x = &x_[0];
+    double* y = &y_[0];
+    const double xMax = sinrPoints_ - 1;
+    const double yMax = blockSizePoints_ - 1;
+
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        x[k] = (sinrs[k] - minSINR_) / sinrResolution_;
+        y[k] = (double(blockSizes[k]) - minBlockSize_) / blockSizeResolution_;
+        found[k] = (x[k] >= 0.0) & (x[k] < xMax) & (y[k] >= 0.0) & (y[k] < yMax);
+    }
+
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        if (!found[k])
+            continue;
+
+        int i = int(x[k]);
+        int j = int(y[k]);
+
+        if (exact_[(phyModes[k] * (sinrPoints_ - 1) + i) * (blockSizePoints_ - 1) + j])
+        {
+            found[k] = 0;
+            continue;
+        }
+
+        pers[k] = interpolate(phyModes[k], i, j, x[k] - i, y[k] - j);
+    }
+}
+
+double
+PERTable::getMaxError() const
+{
+    return maxError_;
+}
+
+int
+PERTable::getNumberOfExactCells() const
+{
+    int n = 0;
+    for (std::vector<bool>::const_iterator it = exact_.begin(); it != exact_.end(); ++it)
+        if (*it)
+            ++n;
+    return n;
+}
@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_PERTABLE_HPP
+#define WIMAC_PERTABLE_HPP
+
+#include <WNS/SmartPtr.hpp>
+#include <WNS/pyconfig/View.hpp>
+
+#include <vector>
+
+namespace wimac {
+
+    /**
+     * @brief Precomputed packet error rates over SINR x block size, one
+     * table per PhyMode.
+     *
+     * Values between grid points are interpolated bilinearly. When the table
+     * is built, every cell is checked against the exact mapping on a grid
+     * of checkPoints + 1 points per axis. Cells that deviate more than
+     * maxError at any of them are marked, and lookups in them fail just like
+     * lookups outside the table, so the caller falls back to the exact
+     * mapping. maxError is only verified at the check points, a denser
+     * grid makes it tighter for curves with sharp bends.
+     */
+    class PERTable :
+        public wns::RefCountable
+    {
+    public:
+        /**
+         * @brief The exact mapping that is tabulated.
+         */
+        class MappingInterface
+        {
+        public:
+            virtual
+            ~MappingInterface() {}
+
+            virtual int
+            getNumberOfPhyModes() const = 0;
+
+            /**
+             * @param sinr in dB
+             */
+            virtual double
+            getPER(int phyMode, double sinr, unsigned int blockSize) const = 0;
+        };
+
+        PERTable(const MappingInterface& mapping, const wns::pyconfig::View& config);
+
+        /**
+         * @brief Look up the PER of a block of blockSize bits received with
+         * the given SINR in dB.
+         *
+         * @return false if the point is not covered by the table with the
+         * configured accuracy. per is not touched in this case.
+         */
+        bool
+        lookup(int phyMode, double sinr, unsigned int blockSize, double& per) const
+        {
+            double x = (sinr - minSINR_) / sinrResolution_;
+            double y = (double(blockSize) - minBlockSize_) / blockSizeResolution_;
+
+            if (x < 0.0 || x >= sinrPoints_ - 1 || y < 0.0 || y >= blockSizePoints_ - 1)
+                return false;
+
+            int i = int(x);
+            int j = int(y);
+
+            if (exact_[(phyMode * (sinrPoints_ - 1) + i) * (blockSizePoints_ - 1) + j])
+                return false;
+
+            per = interpolate(phyMode, i, j, x - i, y - j);
+            return true;
+        }
+
+        /**
+         * @brief Look up n points at once.
+         *
+         * The index computation runs over plain arrays so that the compiler
+         * can vectorize it. found[k] is 0 where the caller has to evaluate
+         * the exact mapping, pers[k] is not touched then.
+         */
+        void
+        lookup(std::size_t n,
+               const int* phyModes,
+               const double* sinrs,
+               const unsigned int* blockSizes,
+               double* pers,
+               char* found) const;
+
+        double
+        getMaxError() const;
+
+        /**
+         * @brief Number of cells (over all PhyModes) that are evaluated
+         * exactly because interpolation is not accurate enough there.
+         */
+        int
+        getNumberOfExactCells() const;
+
+    private:
+        /**
+         * @brief Bilinear interpolation in cell (i, j) at fraction (fx, fy)
+         */
+        double
+        interpolate(int phyMode, int i, int j, double fx, double fy) const
+        {
+            const double* v = &values_[(phyMode * sinrPoints_ + i) * blockSizePoints_ + j];
+
+            return (1.0 - fx) * ((1.0 - fy) * v[0] + fy * v[1])
+                + fx * ((1.0 - fy) * v[blockSizePoints_] + fy * v[blockSizePoints_ + 1]);
+        }
+
+        double minSINR_;
+        double sinrResolution_;
+        int sinrPoints_;
+
+        double minBlockSize_;
+        double blockSizeResolution_;
+        int blockSizePoints_;
+
+        double maxError_;
+
+        std::vector<double> values_;
+        std::vector<bool> exact_;
+
+        // Scratch space of the batch lookup
+        mutable std::vector<double> x_;
+        mutable std::vector<double> y_;
+    };
+
+    typedef wns::SmartPtr<PERTable> PERTablePtr;
+}
+
+#endif // WIMAC_PERTABLE_HPP
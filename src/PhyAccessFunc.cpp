@@ -79,10 +79,10 @@ void
 BroadcastPhyAccessFunc::operator()(wimac::PhyUser* phyUser, const wns::ldk::CompoundPtr& compound )
 {
     assureNotNull(phyMode_.getPtr());
-    StartBroadcastTransmission start ( phyUser, compound, phyMode_ );
+    StartBroadcastTransmission start ( phyUser, compound, phyMode_, subBand_ );
     wns::simulator::getEventScheduler()->schedule( start, transmissionStart_ );
 
-    StopTransmission stop ( phyUser, compound );
+    StopTransmission stop ( phyUser, compound, subBand_ );
     wns::simulator::getEventScheduler()->schedule( stop, transmissionStop_);
 }
 
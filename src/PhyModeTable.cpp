@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/PhyModeTable.hpp>
+
+#include <WNS/Assure.hpp>
+
+#include <cmath>
+#include <map>
+#include <sstream>
+
+using namespace wimac;
+
+namespace {
+
+    typedef std::map<std::pair<const wns::service::phy::phymode::PhyModeMapperInterface*, std::string>,
+                     PhyModeTablePtr> TableMap;
+
+    TableMap&
+    getTables()
+    {
+        static TableMap tables;
+        return tables;
+    }
+}
+
+PhyModeTable::PhyModeTable(wns::service::phy::phymode::PhyModeMapperInterface* mapper,
+                           const wns::pyconfig::View& config) :
+    mapper_(mapper),
+    phyModes_(),
+    minSINR_(config.get<double>("minSINR")),
+    resolution_(config.get<double>("resolution")),
+    bins_(0),
+    index_()
+{
+    assure(mapper_ != NULL, "PhyModeTable needs a PhyModeMapper");
+    assure(resolution_ > 0.0, "resolution must be positive");
+
+    double maxSINR = config.get<double>("maxSINR");
+    assure(maxSINR > minSINR_, "maxSINR must be larger than minSINR");
+
+    for (int i = 0; i < mapper_->getPhyModeCount(); ++i)
+        phyModes_.push_back(mapper_->getPhyModeForIndex(i));
+
+    bins_ = int(std::ceil((maxSINR - minSINR_) / resolution_));
+    index_.resize(bins_);
+
+    // Interval boundaries belong to the lower interval, so the upper edge
+    // of a bin is checked a little below the next bin
+    const double epsilon = resolution_ * 1e-6;
+
+    int lower = getIndex(*mapper_->getBestPhyMode(wns::Ratio::from_dB(minSINR_)));
+    for (int bin = 0; bin < bins_; ++bin)
+    {
+        double edge = minSINR_ + (bin + 1) * resolution_;
+
+        int upper = getIndex(*mapper_->getBestPhyMode(wns::Ratio::from_dB(edge - epsilon)));
+        index_[bin] = (lower == upper) ? lower : -1;
+
+        lower = getIndex(*mapper_->getBestPhyMode(wns::Ratio::from_dB(edge)));
+    }
+}
+
+PhyModeTablePtr
+PhyModeTable::getTable(wns::service::phy::phymode::PhyModeMapperInterface* mapper,
+                       const wns::pyconfig::View& config)
+{
+    std::stringstream key;
+    key << config.get<double>("minSINR") << ":"
+        << config.get<double>("maxSINR") << ":"
+        << config.get<double>("resolution");
+
+    PhyModeTablePtr& table = getTables()[std::make_pair(mapper, key.str())];
+    if (table == PhyModeTablePtr())
+        table = PhyModeTablePtr(new PhyModeTable(mapper, config));
+    return table;
+}
+
+void
+PhyModeTable::clearTables()
+{
+    getTables().clear();
+}
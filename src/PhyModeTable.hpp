@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_PHYMODETABLE_HPP
+#define WIMAC_PHYMODETABLE_HPP
+
+#include <WNS/service/phy/phymode/PhyModeInterface.hpp>
+#include <WNS/service/phy/phymode/PhyModeMapperInterface.hpp>
+#include <WNS/PowerRatio.hpp>
+#include <WNS/SmartPtr.hpp>
+#include <WNS/pyconfig/View.hpp>
+
+#include <vector>
+
+namespace wimac {
+
+    /**
+     * @brief Constant time SINR -> PhyMode selection.
+     *
+     * The SINR range is divided into bins of the configured resolution,
+     * each holding the index of the best PhyMode. Bins that contain an
+     * interval boundary of the mapper are marked and resolved by the
+     * mapper, so the result is always the one of the mapper.
+     *
+     * The PhyModes are interned: all selections return the mapper's own
+     * instances, so they can be shared by commands instead of cloned, and
+     * their index is found by pointer comparison.
+     */
+    class PhyModeTable :
+        public wns::RefCountable
+    {
+    public:
+        PhyModeTable(wns::service::phy::phymode::PhyModeMapperInterface* mapper,
+                     const wns::pyconfig::View& config);
+
+        /**
+         * @brief Table shared by all users of the same mapper and
+         * configuration.
+         */
+        static wns::SmartPtr<PhyModeTable>
+        getTable(wns::service::phy::phymode::PhyModeMapperInterface* mapper,
+                 const wns::pyconfig::View& config);
+
+        /**
+         * @brief Forget the shared tables, the mappers they refer to do
+         * not outlive the simulation.
+         */
+        static void
+        clearTables();
+
+        int
+        getBestPhyModeIndex(double sinr) const
+        {
+            double x = (sinr - minSINR_) / resolution_;
+
+            if (x >= 0.0 && x < bins_)
+            {
+                int index = index_[int(x)];
+                if (index >= 0)
+                    return index;
+            }
+
+            return getIndex(*mapper_->getBestPhyMode(wns::Ratio::from_dB(sinr)));
+        }
+
+        const wns::service::phy::phymode::PhyModeInterfacePtr&
+        getBestPhyMode(const wns::Ratio& sinr) const
+        {
+            return phyModes_[getBestPhyModeIndex(sinr.get_dB())];
+        }
+
+        const wns::service::phy::phymode::PhyModeInterfacePtr&
+        getPhyMode(int index) const
+        {
+            return phyModes_[index];
+        }
+
+        /**
+         * @brief Index of the PhyMode in the mapper
+         *
+         * Interned PhyModes are found by address, others are compared by
+         * the mapper.
+         */
+        int
+        getIndex(const wns::service::phy::phymode::PhyModeInterface& phyMode) const
+        {
+            for (std::size_t i = 0; i < phyModes_.size(); ++i)
+                if (phyModes_[i].getPtr() == &phyMode)
+                    return i;
+
+            return mapper_->getIndexForPhyMode(phyMode);
+        }
+
+        int
+        getNumberOfPhyModes() const
+        {
+            return phyModes_.size();
+        }
+
+    private:
+        wns::service::phy::phymode::PhyModeMapperInterface* mapper_;
+        std::vector<wns::service::phy::phymode::PhyModeInterfacePtr> phyModes_;
+
+        double minSINR_;
+        double resolution_;
+        int bins_;
+
+        /**
+         * @brief PhyMode index per bin, -1 if the bin contains a boundary
+         */
+        std::vector<short> index_;
+    };
+
+    typedef wns::SmartPtr<PhyModeTable> PhyModeTablePtr;
+}
+
+#endif // WIMAC_PHYMODETABLE_HPP
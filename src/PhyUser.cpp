@@ -42,6 +42,7 @@
 #include <WIMAC/Component.hpp>
 #include <WIMAC/Logger.hpp>
 #include <WIMAC/services/InterferenceCache.hpp>
+#include <WIMAC/services/IChannelQualityObserver.hpp>
 #include <WIMAC/StationManager.hpp>
 #include <WIMAC/services/ConnectionManager.hpp>
 #include <WIMAC/frame/DataCollector.hpp>
@@ -60,6 +61,9 @@ PhyUser::PhyUser(wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config) :
     cacheEntryTimeStamp(-1),
     maxAgeCacheEntry(1.0),
     lastInterferenceSlot(-1),
+    subscription_(),
+    foreignFrameHeadInterval_(config.get<wns::simulator::Time>("foreignFrameHeadInterval")),
+    monitorForeignCells_(config.get<bool>("monitorForeignCells")),
     friends_()
 {
     friends_.interferenceCacheName = "interferenceCache";
@@ -71,6 +75,7 @@ PhyUser::PhyUser(wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config) :
     friends_.interferenceCache = NULL;
     friends_.connectionManager = NULL;
     friends_.connectionClassifier = NULL;
+    friends_.channelQualityObserver = NULL;
 
     // Probes configure
 	wns::probe::bus::ContextProviderCollection* cpcParent = &fun->getLayer()->getContextProviderCollection();
@@ -135,9 +140,14 @@ PhyUser::PhyUser( const PhyUser& rhs ):
 	wns::ldk::HasConnector<>( rhs ),
 	wns::ldk::HasDeliverer<>( rhs ),
 	wns::Cloneable<PhyUser>( rhs ),
+	wns::Observer<service::ConnectionAddedNotification>(),
+	wns::Observer<service::ConnectionDeletedNotification>(),
 	cacheEntryTimeStamp(-1),
 	maxAgeCacheEntry(1.0),
     lastInterferenceSlot(-1),
+    subscription_(),
+    foreignFrameHeadInterval_(rhs.foreignFrameHeadInterval_),
+    monitorForeignCells_(rhs.monitorForeignCells_),
 	friends_()
 {
 	friends_.interferenceCacheName = rhs.friends_.interferenceCacheName;
@@ -148,7 +158,7 @@ PhyUser::PhyUser( const PhyUser& rhs ):
 	friends_.layer = NULL;
 	friends_.interferenceCache = NULL;
 	friends_.connectionManager = NULL;
-
+	friends_.channelQualityObserver = NULL;
 
     probes_.interferenceSDMA = wns::probe::bus::ContextCollectorPtr(
         new wns::probe::bus::ContextCollector(
@@ -242,9 +252,53 @@ void PhyUser::onFUNCreated()
     }
     assure(friends_.registry != NULL, "Unable to get RegistryProxy");
 
+    if(friends_.layer->getStationType() != wns::service::dll::StationTypes::AP())
+    {
+        friends_.channelQualityObserver = friends_.layer
+            ->getControlService<service::IChannelQualityObserver>("associationControl");
+
+        wns::Observer<service::ConnectionAddedNotification>
+            ::startObserving(friends_.connectionManager);
+        wns::Observer<service::ConnectionDeletedNotification>
+            ::startObserving(friends_.connectionManager);
+
+        // Associated before we started observing
+        ConnectionIdentifier::Ptr rngCI =
+            friends_.connectionManager->getConnectionWithID(0);
+        if(rngCI)
+            notifyAboutConnectionAdded(*rngCI);
+    }
+
 	cacheEntryTimeStamp = -maxAgeCacheEntry;
 }
 
+void
+PhyUser::notifyAboutConnectionAdded(const ConnectionIdentifier cid)
+{
+    // The ranging connection is the first one set up during association
+    if(cid.cid_ != 0)
+        return;
+
+    subscription_.associated = true;
+    subscription_.baseStation = cid.baseStation_;
+    lastForeignFrameHead_.erase(cid.baseStation_);
+
+    LOG_INFO(getFUN()->getLayer()->getName(),
+             ": subscribed to broadcasts of cell ", cid.baseStation_);
+}
+
+void
+PhyUser::notifyAboutConnectionDeleted(const ConnectionIdentifier cid)
+{
+    if(cid.cid_ != 0)
+        return;
+
+    subscription_ = Subscription();
+
+    LOG_INFO(getFUN()->getLayer()->getName(),
+             ": unsubscribed from broadcasts of cell ", cid.baseStation_);
+}
+
 
 
 void
@@ -283,11 +337,16 @@ void
 PhyUser::onData(wns::osi::PDUPtr pdu,
         wns::service::phy::power::PowerMeasurementPtr rxPowerMeasurement)
 {
-    wns::ldk::CompoundPtr compound = wns::staticCast<wns::ldk::Compound>(pdu)->copy();
+    wns::ldk::CompoundPtr received = wns::staticCast<wns::ldk::Compound>(pdu);
     if(!getFUN()->getProxy()->commandIsActivated(
-        compound->getCommandPool(), this))      
+        received->getCommandPool(), this))      
             return;
 
+    // Reject foreign-cell receptions before paying for the copy
+    if(!isSubscribed(getCommand(received->getCommandPool())))
+        return;
+
+    wns::ldk::CompoundPtr compound = received->copy();
     PhyUserCommand* puCommand = getCommand( compound->getCommandPool() );
 
     // store measured signal into PhyUserCommand
@@ -301,6 +360,17 @@ PhyUser::onData(wns::osi::PDUPtr pdu,
 
     puCommand->magic.rxMeasurement = rxPowerMeasurement;
 
+    // Sampled frame head of a neighbour cell: only the measurement is of
+    // interest, the frame timing follows the serving cell
+    if(subscription_.associated
+       && puCommand->magic.frameHead_
+       && puCommand->magic.sourceComponent_->getID() != subscription_.baseStation)
+    {
+        friends_.channelQualityObserver->storeMeasurement(
+            puCommand->magic.sourceComponent_->getID(), rxPowerMeasurement);
+        return;
+    }
+
     // Only proceed on filtered compounds
     if ( !filter( compound ) )
         return;
@@ -401,12 +471,24 @@ PhyUser::onData(wns::osi::PDUPtr pdu,
         LOG_INFO( "pathloss from PhyUser:",txPower.get_dBm() - rxPower.get_dBm());
     
         /* Probe deviation between possible and chosen PHY mode*/
-		int phyModeIndex =
-			friends_.registry->getPhyModeMapper()->
-                getIndexForPhyMode(*puCommand->peer.phyModePtr);
-        int possiblePhyModeIndex = 
-            friends_.registry->getPhyModeMapper()->getIndexForPhyMode(
-                *friends_.registry->getPhyModeMapper()->getBestPhyMode(rxPower / interference));
+        int phyModeIndex;
+        int possiblePhyModeIndex;
+        PhyModeTable* phyModeTable = friends_.registry->getPhyModeTable();
+        if (phyModeTable != NULL)
+        {
+            phyModeIndex = phyModeTable->getIndex(*puCommand->peer.phyModePtr);
+            possiblePhyModeIndex = phyModeTable->getBestPhyModeIndex(
+                (rxPower / interference).get_dB());
+        }
+        else
+        {
+            phyModeIndex =
+                friends_.registry->getPhyModeMapper()->
+                    getIndexForPhyMode(*puCommand->peer.phyModePtr);
+            possiblePhyModeIndex = 
+                friends_.registry->getPhyModeMapper()->getIndexForPhyMode(
+                    *friends_.registry->getPhyModeMapper()->getBestPhyMode(rxPower / interference));
+        }
 
 		probes_.deltaPHYModeSDMA->put(compound, possiblePhyModeIndex - phyModeIndex);
 
@@ -494,10 +576,7 @@ bool PhyUser::filter( const wns::ldk::CompoundPtr& compound)
     // SS should receive all broadcasts
     if( friends_.layer->getStationType() != wns::service::dll::StationTypes::AP() )
     {
-        ConnectionIdentifier::Ptr rngCI;
-        rngCI = friends_.connectionManager->getConnectionWithID(0);
-
-        if(rngCI == NULL)
+        if(!subscription_.associated)
         {
             if(phyCommand->magic.frameHead_)
             {
@@ -513,7 +592,7 @@ bool PhyUser::filter( const wns::ldk::CompoundPtr& compound)
         }
         if ( !phyCommand->peer.destination_       //broadcast
                 && ( phyCommand->magic.sourceComponent_->getID()
-                    == rngCI->baseStation_ )                // from our BaseStation
+                    == subscription_.baseStation )          // from our BaseStation
             )
         {
             return true;
@@ -580,6 +659,52 @@ bool PhyUser::filter( const wns::ldk::CompoundPtr& compound)
     return false;
 }
 
+bool
+PhyUser::isSubscribed(PhyUserCommand* phyCommand)
+{
+    // reject own compounds
+    if ( phyCommand->peer.source_ == friends_.layer->getNode() )
+        return false;
+
+    // The BS probes interference on receptions not meant for it
+    if( friends_.layer->getStationType() == wns::service::dll::StationTypes::AP() )
+        return true;
+
+    if ( phyCommand->peer.destination_ )
+        return phyCommand->peer.destination_ == friends_.layer->getNode();
+
+    ConnectionIdentifier::StationID source =
+        phyCommand->magic.sourceComponent_->getID();
+
+    if ( subscription_.associated && source == subscription_.baseStation )
+        return true;
+
+    // Foreign broadcasts: only frame heads, for association and handover
+    if ( !phyCommand->magic.frameHead_ )
+        return false;
+
+    if ( subscription_.associated && !monitorForeignCells_ )
+        return false;
+
+    return sampleForeignFrameHead(source);
+}
+
+bool
+PhyUser::sampleForeignFrameHead(ConnectionIdentifier::StationID baseStation)
+{
+    wns::simulator::Time now = wns::simulator::getEventScheduler()->getTime();
+
+    std::map<ConnectionIdentifier::StationID, wns::simulator::Time>::iterator it =
+        lastForeignFrameHead_.find(baseStation);
+
+    if(it != lastForeignFrameHead_.end()
+       && now - it->second < foreignFrameHeadInterval_)
+        return false;
+
+    lastForeignFrameHead_[baseStation] = now;
+    return true;
+}
+
 void
 PhyUser::traceIncoming(wns::ldk::CompoundPtr compound, wns::service::phy::power::PowerMeasurementPtr rxPowerMeasurement)
 {
@@ -33,6 +33,8 @@
 #include <WNS/probe/bus/ContextCollector.hpp>
 #include <WNS/probe/bus/json/probebus.hpp>
 
+#include <map>
+
 #include <WNS/ldk/FunctionalUnit.hpp>
 #include <WNS/ldk/Compound.hpp>
 #include <WNS/ldk/CommandTypeSpecifier.hpp>
@@ -48,9 +50,11 @@
 #include <WNS/service/dll/Address.hpp>
 
 #include <WNS/pyconfig/View.hpp>
+#include <WNS/Observer.hpp>
 
 #include <WIMAC/PhyUserCommand.hpp>
 #include <WIMAC/scheduler/RegistryProxyWiMAC.hpp>
+#include <WIMAC/services/ConnectionManager.hpp>
 
 
 #include <WNS/service/phy/phymode/PhyModeMapperInterface.hpp>
@@ -69,6 +73,7 @@ namespace wimac {
     namespace service {
         class ConnectionManager;
         class InterferenceCache;
+        class IChannelQualityObserver;
     }
 
     class ConnectionClassifier;
@@ -78,6 +83,13 @@ namespace wimac {
     /**
      * @brief The PhyUser receives all incoming compounds.
      *
+     * A subscriber station only hands up what it is subscribed to: the
+     * broadcasts of its serving cell and unicasts addressed to itself. The
+     * subscription follows the ConnectionManager, so receptions from foreign
+     * cells are rejected before the compound is copied. Frame heads of
+     * foreign cells are sampled at most once per foreignFrameHeadInterval
+     * and source station.
+     *
      * @todo The PhyUser should not control the FrameBuilder. The PhyUser is a
      * passive element of the FUN.
      *
@@ -91,7 +103,9 @@ namespace wimac {
         public wns::ldk::HasReceptor<>,
         public wns::ldk::HasConnector<>,
         public wns::ldk::HasDeliverer<>,
-        public wns::Cloneable<PhyUser>
+        public wns::Cloneable<PhyUser>,
+        public wns::Observer<service::ConnectionAddedNotification>,
+        public wns::Observer<service::ConnectionDeletedNotification>
     {
         enum States {initial, receiving, measuring};
 
@@ -133,7 +147,24 @@ namespace wimac {
 
         void onFUNCreated();
 
+        // ConnectionManager observer
+        virtual void
+        notifyAboutConnectionAdded(const ConnectionIdentifier cid);
+
+        virtual void
+        notifyAboutConnectionDeleted(const ConnectionIdentifier cid);
+
     private:
+        /**
+         * @brief Cheap check on the received PDU's command pool, done
+         * before the compound is copied.
+         */
+        bool
+        isSubscribed(PhyUserCommand* phyCommand);
+
+        bool
+        sampleForeignFrameHead(ConnectionIdentifier::StationID baseStation);
+
         void
         traceIncoming(wns::ldk::CompoundPtr compound, wns::service::phy::power::PowerMeasurementPtr rxPowerMeasurement);
 
@@ -152,6 +183,34 @@ namespace wimac {
         int lastInterferenceSlot;
         wns::Power interferenceForSlot;
 
+        /**
+         * @brief Receptions a subscriber station is interested in. Only
+         * valid if associated is true.
+         */
+        struct Subscription {
+            Subscription() :
+                associated(false),
+                baseStation(0)
+            {}
+
+            bool associated;
+            ConnectionIdentifier::StationID baseStation;
+        } subscription_;
+
+        /**
+         * @brief Minimum time between two accepted frame heads of the same
+         * foreign base station. 0.0 accepts every frame head.
+         */
+        wns::simulator::Time foreignFrameHeadInterval_;
+
+        /**
+         * @brief Pass sampled foreign frame heads to the association control
+         * while associated, e.g. for handover decisions.
+         */
+        bool monitorForeignCells_;
+
+        std::map<ConnectionIdentifier::StationID, wns::simulator::Time> lastForeignFrameHead_;
+
         struct{
 
             wns::probe::bus::ContextCollectorPtr interferenceSDMA;
@@ -187,6 +246,7 @@ namespace wimac {
             service::ConnectionManager* connectionManager;
             ConnectionClassifier* connectionClassifier;
             wimac::scheduler::RegistryProxyWiMAC* registry;
+            service::IChannelQualityObserver* channelQualityObserver;
         } friends_;
     };
 }
@@ -0,0 +1,222 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/SDUPacking.hpp>
+#include <WIMAC/Logger.hpp>
+
+#include <WNS/ldk/fun/FUN.hpp>
+#include <WNS/ldk/Layer.hpp>
+#include <WNS/simulator/ISimulator.hpp>
+
+#include <boost/bind.hpp>
+
+
+STATIC_FACTORY_REGISTER_WITH_CREATOR(
+    wimac::SDUPacking,
+    wns::ldk::FunctionalUnit,
+    "wimac.SDUPacking",
+    wns::ldk::FUNConfigCreator);
+
+using namespace wimac;
+
+SDUPacking::SDUPacking(wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config) :
+    wns::ldk::CommandTypeSpecifier<SDUPackingCommand>(fun),
+    wns::ldk::HasConnector<>(),
+    wns::ldk::HasReceptor<>(),
+    wns::ldk::HasDeliverer<>(),
+    targetSize_(config.get<Bit>("targetSize")),
+    maxDelay_(config.get<wns::simulator::Time>("maxDelay")),
+    subHeaderSize_(config.get<Bit>("subHeaderSize")),
+    classifierName_(config.get<std::string>("classifier")),
+    classifier_(NULL)
+{
+}
+
+void
+SDUPacking::onFUNCreated()
+{
+    classifier_ = getFUN()->
+        findFriend<wns::ldk::CommandTypeSpecifier<wns::ldk::ClassifierCommand>*>(classifierName_);
+    assure(classifier_, "classifier not found in FUN");
+}
+
+void
+SDUPacking::doSendData(const wns::ldk::CompoundPtr& compound)
+{
+    ConnectionIdentifier::CID cid =
+        classifier_->getCommand(compound->getCommandPool())->peer.id;
+    Bit bits = compound->getLengthInBits() + subHeaderSize_;
+
+    // The SDU does not fit into the PDU being collected
+    PendingSDUs::iterator it = pending_.find(cid);
+    if (it != pending_.end()
+        && !it->second.back().closed
+        && it->second.back().bits + bits > targetSize_)
+        close(cid);
+
+    std::list<Pending>& pdus = pending_[cid];
+    if (pdus.empty() || pdus.back().closed)
+        pdus.push_back(Pending());
+
+    Pending& pending = pdus.back();
+    pending.sdus.push_back(compound);
+    pending.bits += bits;
+
+    if (pending.bits >= targetSize_)
+    {
+        close(cid);
+        return;
+    }
+
+    if (pending.timeout == wns::events::scheduler::IEventPtr())
+    {
+        pending.timeout = wns::simulator::getEventScheduler()->scheduleDelay(
+            boost::bind(&SDUPacking::onTimeout, this, cid), maxDelay_);
+    }
+}
+
+bool
+SDUPacking::doIsAccepting(const wns::ldk::CompoundPtr& compound) const
+{
+    return getConnector()->hasAcceptor(compound);
+}
+
+void
+SDUPacking::doWakeup()
+{
+    // Retry the PDUs the lower FU did not accept yet
+    std::vector<ConnectionIdentifier::CID> blocked;
+    for (PendingSDUs::const_iterator it = pending_.begin(); it != pending_.end(); ++it)
+    {
+        if (it->second.front().closed)
+            blocked.push_back(it->first);
+    }
+
+    for (std::vector<ConnectionIdentifier::CID>::const_iterator it = blocked.begin();
+         it != blocked.end(); ++it)
+        flush(*it);
+
+    getReceptor()->wakeup();
+}
+
+void
+SDUPacking::onTimeout(ConnectionIdentifier::CID cid)
+{
+    pending_[cid].back().timeout = wns::events::scheduler::IEventPtr();
+    close(cid);
+}
+
+void
+SDUPacking::close(ConnectionIdentifier::CID cid)
+{
+    PendingSDUs::iterator it = pending_.find(cid);
+    assure(it != pending_.end() && !it->second.back().closed,
+           "SDUPacking: nothing to close for CID " << cid);
+
+    Pending& pending = it->second.back();
+    pending.closed = true;
+    if (pending.timeout != wns::events::scheduler::IEventPtr())
+    {
+        wns::simulator::getEventScheduler()->cancelEvent(pending.timeout);
+        pending.timeout = wns::events::scheduler::IEventPtr();
+    }
+
+    flush(cid);
+}
+
+bool
+SDUPacking::flush(ConnectionIdentifier::CID cid)
+{
+    // Looked up again after each PDU, the lower FU may wake us up while
+    // sending
+    for (PendingSDUs::iterator it = pending_.find(cid);
+         it != pending_.end() && it->second.front().closed;
+         it = pending_.find(cid))
+    {
+        const Pending& pending = it->second.front();
+
+        wns::ldk::CompoundPtr pdu;
+        if (pending.sdus.size() == 1)
+        {
+            pdu = pending.sdus.front();
+        }
+        else
+        {
+            pdu = wns::ldk::CompoundPtr(
+                new wns::ldk::Compound(getFUN()->getProxy()->createCommandPool()));
+            classifier_->activateCommand(pdu->getCommandPool())->peer.id = cid;
+            activateCommand(pdu->getCommandPool())->peer.sdus = pending.sdus;
+        }
+
+        // retried on the next wakeup
+        if (!getConnector()->hasAcceptor(pdu))
+            return false;
+
+        LOG_INFO(getFUN()->getLayer()->getName(), ": packing ", pending.sdus.size(),
+                 " SDUs of CID ", cid, " into one PDU");
+
+        it->second.pop_front();
+        if (it->second.empty())
+            pending_.erase(it);
+
+        getConnector()->getAcceptor(pdu)->sendData(pdu);
+    }
+    return true;
+}
+
+void
+SDUPacking::doOnData(const wns::ldk::CompoundPtr& compound)
+{
+    if (!getFUN()->getProxy()->commandIsActivated(compound->getCommandPool(), this))
+    {
+        getDeliverer()->getAcceptor(compound)->onData(compound);
+        return;
+    }
+
+    SDUPackingCommand* command = getCommand(compound->getCommandPool());
+    for (SDUPackingCommand::SDUs::const_iterator it = command->peer.sdus.begin();
+         it != command->peer.sdus.end(); ++it)
+    {
+        // the SDUs of the sender must not be modified
+        wns::ldk::CompoundPtr sdu = (*it)->copy();
+        getDeliverer()->getAcceptor(sdu)->onData(sdu);
+    }
+}
+
+void
+SDUPacking::calculateSizes(const wns::ldk::CommandPool* commandPool,
+                           Bit& commandPoolSize, Bit& dataSize) const
+{
+    getFUN()->getProxy()->calculateSizes(commandPool, commandPoolSize, dataSize, this);
+
+    if (!getFUN()->getProxy()->commandIsActivated(commandPool, this))
+        return;
+
+    // The packed SDUs replace the payload
+    SDUPackingCommand* command = getCommand(commandPool);
+    for (SDUPackingCommand::SDUs::const_iterator it = command->peer.sdus.begin();
+         it != command->peer.sdus.end(); ++it)
+        dataSize += (*it)->getLengthInBits() + subHeaderSize_;
+}
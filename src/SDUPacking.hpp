@@ -0,0 +1,159 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_SDUPACKING_HPP
+#define WIMAC_SDUPACKING_HPP
+
+#include <WNS/ldk/ldk.hpp>
+
+#include <WNS/Cloneable.hpp>
+#include <WNS/ldk/CommandTypeSpecifier.hpp>
+#include <WNS/ldk/HasDeliverer.hpp>
+#include <WNS/ldk/HasConnector.hpp>
+#include <WNS/ldk/HasReceptor.hpp>
+#include <WNS/ldk/FunctionalUnit.hpp>
+#include <WNS/ldk/Command.hpp>
+#include <WNS/ldk/Classifier.hpp>
+#include <WNS/events/scheduler/Interface.hpp>
+#include <WNS/simulator/Bit.hpp>
+#include <WNS/simulator/Time.hpp>
+#include <WIMAC/ConnectionIdentifier.hpp>
+
+#include <list>
+#include <map>
+#include <vector>
+
+namespace wimac {
+
+    /**
+     * @brief The Command for the SDUPacking.
+     */
+    class SDUPackingCommand
+        : public wns::ldk::Command
+    {
+    public:
+        typedef std::vector<wns::ldk::CompoundPtr> SDUs;
+
+        struct {
+        } local;
+
+        struct {
+            /**
+             * @brief The SDUs packed into this MAC PDU
+             */
+            SDUs sdus;
+        } peer;
+
+        struct {
+        } magic;
+    };
+
+    /**
+     * @brief Packs the SDUs of one CID into a single MAC PDU.
+     *
+     * SDUs are collected per CID until the next one would exceed the
+     * target size or the first one has waited for maxDelay. The PDU is
+     * then closed and waits for the lower FU, new SDUs start the next
+     * PDU of the CID. A PDU with
+     * more than one SDU pays one packing subheader per SDU instead of a
+     * MAC header and MAP IE each, a single SDU is passed on unchanged.
+     * The peer SDUPacking delivers the packed SDUs one by one.
+     */
+    class SDUPacking :
+        public wns::ldk::CommandTypeSpecifier<SDUPackingCommand>,
+        public wns::ldk::HasConnector<>,
+        public wns::ldk::HasReceptor<>,
+        public wns::ldk::HasDeliverer<>,
+        public wns::Cloneable<SDUPacking>
+    {
+    public:
+        SDUPacking(wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config);
+
+        void onFUNCreated();
+
+        void
+        calculateSizes(const wns::ldk::CommandPool* commandPool,
+                       Bit& commandPoolSize, Bit& dataSize) const;
+
+    private:
+        virtual void
+        doSendData(const wns::ldk::CompoundPtr& compound);
+
+        virtual void
+        doOnData(const wns::ldk::CompoundPtr& compound);
+
+        virtual bool
+        doIsAccepting(const wns::ldk::CompoundPtr& compound) const;
+
+        virtual void
+        doWakeup();
+
+        /**
+         * @brief Close the PDU collected for cid and pass it on
+         */
+        void
+        close(ConnectionIdentifier::CID cid);
+
+        /**
+         * @brief Pass the closed PDUs of cid on, returns false if the
+         * lower FU does not accept them yet.
+         */
+        bool
+        flush(ConnectionIdentifier::CID cid);
+
+        void
+        onTimeout(ConnectionIdentifier::CID cid);
+
+        Bit targetSize_;
+        wns::simulator::Time maxDelay_;
+        Bit subHeaderSize_;
+        std::string classifierName_;
+
+        struct Pending
+        {
+            Pending() :
+                bits(0),
+                closed(false)
+            {}
+
+            SDUPackingCommand::SDUs sdus;
+            Bit bits;
+            bool closed;
+            wns::events::scheduler::IEventPtr timeout;
+        };
+
+        /**
+         * @brief Closed PDUs in sending order, the last one may still be
+         * collecting
+         */
+        typedef std::map<ConnectionIdentifier::CID, std::list<Pending> > PendingSDUs;
+        PendingSDUs pending_;
+
+        // friends
+        wns::ldk::CommandTypeSpecifier<wns::ldk::ClassifierCommand>* classifier_;
+    };
+}
+
+#endif
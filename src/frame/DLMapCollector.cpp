@@ -25,6 +25,8 @@
 
 #include <WIMAC/frame/DLMapCollector.hpp>
 
+#include <sstream>
+
 #include <WNS/ldk/Compound.hpp>
 #include <WNS/ldk/fcf/TimingControl.hpp>
 
@@ -35,6 +37,7 @@
 #include <WIMAC/PhyAccessFunc.hpp>
 #include <WIMAC/Utilities.hpp>
 #include <WIMAC/frame/DataCollector.hpp>
+#include <WIMAC/frame/TimingControl.hpp>
 #include <WIMAC/scheduler/Scheduler.hpp>
 #include <WIMAC/parameter/PHY.hpp>
 
@@ -54,7 +57,11 @@ DLMapCollector::DLMapCollector( wns::ldk::fun::FUN* fun, const wns::pyconfig::Vi
     dlSchedulerName_(),
     phyUser_(0),
     phyMode(wns::SmartPtr<const wns::service::phy::phymode::PhyModeInterface>
-            (wns::service::phy::phymode::createPhyMode( config.getView("phyMode") ) ) )
+            (wns::service::phy::phymode::createPhyMode( config.getView("phyMode") ) ) ),
+    mapSizing_(config.getView("mapSizing"), phyMode),
+    dlDataCollector_(0),
+    ulDataCollector_(0),
+    ulMapCollector_(0)
 {
     if ( !config.isNone("dlSchedulerName") )
         dlSchedulerName_ = config.get<std::string>("dlSchedulerName");
@@ -80,6 +87,16 @@ void DLMapCollector::onFUNCreated()
         getFUN()->getLayer()->getManagementService<service::ConnectionManager>
         ("connectionManager");
 
+    if ( getFUN()->knowsFunctionalUnit("dlscheduler")
+         && getFUN()->knowsFunctionalUnit("ulscheduler") )
+    {
+        dlDataCollector_ = getFUN()->findFriend<DataCollector*>("dlscheduler");
+        ulDataCollector_ = getFUN()->findFriend<DataCollector*>("ulscheduler");
+    }
+
+    if ( getFUN()->knowsFunctionalUnit("ulmapcollector") )
+        ulMapCollector_ = getFUN()->findFriend<ULMapCollector*>("ulmapcollector");
+
     setFrameBuilder( getFUN()->findFriend<wns::ldk::fcf::FrameBuilder*>("frameBuilder") );
     CompoundCollector::onFUNCreated();
 }
@@ -91,17 +108,23 @@ void DLMapCollector::doStart(int mode)
     {
         assure(dlScheduler_, "DLMapCollector can not send, no DL Scheduler set");
 
+        if ( template_ == wns::ldk::CompoundPtr() )
+            createTemplate();
+
+        // hand the time the MAPs leave to the DL strategy before the
+        // DL-MAP announces the bursts
+        dlScheduler_->scheduleGainedTimeSlots( getGainedTimeSlots() );
+
         // create the MAP and send it
-        wns::ldk::CompoundPtr compound
-            ( new wns::ldk::Compound( getFUN()->getProxy()->createCommandPool() ) );
+        wns::ldk::CompoundPtr compound = template_->copy();
 
-        DLMapCommand* command = activateCommand( compound->getCommandPool() );
+        DLMapCommand* command = getCommand( compound->getCommandPool() );
         command->peer.phaseDuration =
             dlScheduler_->getDuration();
-        command->peer.baseStationID =
-            component_->getID();
         command->local.numBursts =
             dlScheduler_->getNumBursts();
+        command->local.mapSize =
+            mapSizing_.getSize(dlScheduler_->getBursts());
         command->local.mapDuration =
             getCurrentDuration() - Utilities::getComputationalAccuracyFactor();
 
@@ -111,26 +134,13 @@ void DLMapCollector::doStart(int mode)
         assure( command->local.mapDuration <= this->getMaximumDuration(),
                 "DLMapWriter: PDU overun the maximum duration of the frame phase!");
 
-        PhyUserCommand* phyCommand =
-            dynamic_cast<PhyUserCommand*>(
-                getFUN()->getProxy()->activateCommand( compound->getCommandPool(),
-                                                       phyUser_ ) );
-
-        phyCommand->peer.destination_ = 0;
+        PhyUserCommand* phyCommand = phyUser_->getCommand( compound->getCommandPool() );
         phyCommand->peer.cellID_ = component_->getCellID();
-        phyCommand->peer.source_ = component_->getNode();
-        assureNotNull(&phyMode);
-        phyCommand->peer.phyModePtr = phyMode;
-        phyCommand->magic.sourceComponent_ = component_;
-
 
         wns::simulator::Time now = wns::simulator::getEventScheduler()->getTime();
-        phyCommand->local.pAFunc_.reset
-            ( new BroadcastPhyAccessFunc );
         phyCommand->local.pAFunc_->transmissionStart_ = now;
         phyCommand->local.pAFunc_->transmissionStop_ =
             now + getCurrentDuration() - Utilities::getComputationalAccuracyFactor();
-        phyCommand->local.pAFunc_->phyMode_ = phyMode;
 
         setTimeout( getCurrentDuration() );
         LOG_INFO("Sending DL MAP in ", getFUN()->getName(),
@@ -146,6 +156,32 @@ void DLMapCollector::doStart(int mode)
     }
 }
 
+void
+DLMapCollector::createTemplate()
+{
+    template_ = wns::ldk::CompoundPtr(
+        new wns::ldk::Compound( getFUN()->getProxy()->createCommandPool() ) );
+
+    DLMapCommand* command = activateCommand( template_->getCommandPool() );
+    command->peer.baseStationID =
+        component_->getID();
+
+    PhyUserCommand* phyCommand =
+        dynamic_cast<PhyUserCommand*>(
+            getFUN()->getProxy()->activateCommand( template_->getCommandPool(),
+                                                   phyUser_ ) );
+
+    phyCommand->peer.destination_ = 0;
+    phyCommand->peer.source_ = component_->getNode();
+    assureNotNull(&phyMode);
+    phyCommand->peer.phyModePtr = phyMode;
+    phyCommand->magic.sourceComponent_ = component_;
+
+    phyCommand->local.pAFunc_.reset
+        ( new BroadcastPhyAccessFunc );
+    phyCommand->local.pAFunc_->phyMode_ = phyMode;
+}
+
 void
 DLMapCollector::calculateSizes( const wns::ldk::CommandPool* commandPool,
                                 Bit& commandPoolSize, Bit& dataSize ) const
@@ -154,7 +190,7 @@ DLMapCollector::calculateSizes( const wns::ldk::CommandPool* commandPool,
     getFUN()->getProxy()->calculateSizes(commandPool, commandPoolSize, dataSize, this);
 
     DLMapCommand* command = getCommand( commandPool );
-    commandPoolSize += ( 56 + command->local.numBursts * 48 );
+    commandPoolSize += command->local.mapSize;
 }
 
 void
@@ -165,17 +201,57 @@ DLMapCollector::onTimeout()
 
 wns::simulator::Time DLMapCollector::getCurrentDuration() const
 {
-    double dataRate =
-        phyMode->getDataRate();
+    wns::simulator::Time duration = mapSizing_.getDuration(dlScheduler_->getBursts());
+
+    if (duration > getMaximumDuration())
+    {
+        std::stringstream ss;
+        ss << getFUN()->getLayer()->getName() << ": DL-MAP of " << duration
+           << "s does not fit into its phase of " << getMaximumDuration()
+           << "s, use a longer MAP phase or a compressed MAP format";
+        throw wns::Exception( ss.str() );
+    }
+    return duration;
+}
+
+int
+DLMapCollector::getGainedTimeSlots() const
+{
+    TimingControl* timingControl =
+        dynamic_cast<TimingControl*>(getFrameBuilder()->getTimingControl());
+
+    if ( timingControl == NULL || !timingControl->hasElasticPhases() )
+        return 0;
+
+    wns::simulator::Time mapDuration = getCurrentDuration();
+    wns::simulator::Time gained = getMaximumDuration() - mapDuration;
+
+    if ( ulMapCollector_ != NULL )
+        gained += timingControl->getPhaseDuration(ulMapCollector_)
+            - ulMapCollector_->getMapDuration();
+
+    wns::simulator::Time slotDuration = dlScheduler_->getSlotDuration();
+    int maxTimeSlots = int(gained / slotDuration);
 
-    Bit compoundSize =
-        56 + dlScheduler_->getNumBursts(); /* *48*/;
+    // worst case: every gained slot adds a burst on each subchannel and beam
+    wimac::scheduler::Scheduler::Burst burst;
+    burst.phyMode = phyMode;
+    int burstsPerSlot = dlScheduler_->getNumberOfSubChannels() * dlScheduler_->getMaxBeams();
 
-    wns::simulator::Time symbolDuration = parameter::ThePHY::getInstance()->getSymbolDuration();
-    wns::simulator::Time roundedDuration =
-        ceil( (compoundSize / dataRate ) / symbolDuration ) * symbolDuration;
-    //fixme(bmw) (fixed map overhead of one symbol due to wrong calculation of map duration with subchannels)
-    return symbolDuration; //roundedDuration;
+    for ( int timeSlots = maxTimeSlots; timeSlots > 0; --timeSlots )
+    {
+        wimac::scheduler::Scheduler::Bursts bursts = dlScheduler_->getBursts();
+        bursts.insert(bursts.end(), timeSlots * burstsPerSlot, burst);
+
+        if ( timeSlots * slotDuration + mapSizing_.getDuration(bursts) - mapDuration
+             <= gained - Utilities::getComputationalAccuracyFactor() )
+        {
+            LOG_INFO( getFUN()->getLayer()->getName(), ": MAPs leave ", gained,
+                      "s, DL data phase gains ", timeSlots, " time slots");
+            return timeSlots;
+        }
+    }
+    return 0;
 }
 
 void DLMapCollector::doOnData( const wns::ldk::CompoundPtr& compound )
@@ -196,5 +272,19 @@ void DLMapCollector::doOnData( const wns::ldk::CompoundPtr& compound )
 
     dlPhaseDuration_ = command->peer.phaseDuration;
 
+    // Follow the DL/UL split of the BS for this frame
+    TimingControl* timingControl =
+        dynamic_cast<TimingControl*>(getFrameBuilder()->getTimingControl());
+
+    if ( timingControl && dlDataCollector_ && ulDataCollector_ )
+    {
+        wns::simulator::Time delta =
+            dlPhaseDuration_ - timingControl->getPhaseDuration(dlDataCollector_);
+
+        if ( delta > Utilities::getComputationalAccuracyFactor()
+             || -delta > Utilities::getComputationalAccuracyFactor() )
+            timingControl->movePhaseBoundary(dlDataCollector_, ulDataCollector_, delta);
+    }
+
     getFrameBuilder()->getTimingControl()->finishedPhase( this );
 }
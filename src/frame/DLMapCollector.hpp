@@ -35,6 +35,7 @@
 
 #include <WIMAC/frame/MapCommand.hpp>
 #include <WIMAC/frame/ULMapCollector.hpp>
+#include <WIMAC/frame/MapSizing.hpp>
 
 namespace wimac {
     class Component;
@@ -47,7 +48,7 @@ namespace wimac {
     }
 
     namespace frame {
-
+        class DataCollector;
 
         typedef MapCommand DLMapCommand;
 
@@ -105,15 +106,40 @@ namespace wimac {
             wns::simulator::Time getDLPhaseDuration() const { return dlPhaseDuration_; }
 
         private:
+            /**
+             * @brief Build the compound that is copied for each MAP.
+             */
+            void createTemplate();
+
+            /**
+             * @brief Time slots the DL data phase gains from the unused
+             * time of both MAP phases with elastic phases.
+             *
+             * Room is left for one more IE per subchannel and beam in
+             * each gained slot, so the DL-MAP announcing their bursts
+             * still fits.
+             */
+            int getGainedTimeSlots() const;
+
             wimac::scheduler::Scheduler* dlScheduler_;
             std::string dlSchedulerName_;
             wimac::Component* component_;
             wimac::PhyUser* phyUser_;
             wns::SmartPtr<const wns::service::phy::phymode::PhyModeInterface> phyMode;
+            MapSizing mapSizing_;
+
+            /**
+             * @brief MAP with all fields set that do not change from frame
+             * to frame.
+             */
+            wns::ldk::CompoundPtr template_;
 
             // members that are only used by the receiving MapCollector
             wimac::service::ConnectionManager* connectionManager_;
             wns::simulator::Time dlPhaseDuration_;
+            DataCollector* dlDataCollector_;
+            DataCollector* ulDataCollector_;
+            ULMapCollector* ulMapCollector_;
         };
     }
 }
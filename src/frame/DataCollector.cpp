@@ -28,10 +28,15 @@
 #include <WNS/pyconfig/View.hpp>
 
 #include <WIMAC/scheduler/Scheduler.hpp>
+#include <WIMAC/frame/TimingControl.hpp>
+#include <WIMAC/ErrorModelling.hpp>
 #include <WIMAC/Utilities.hpp>
+#include <WIMAC/Logger.hpp>
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
+
 STATIC_FACTORY_REGISTER_WITH_CREATOR(
     wimac::frame::DataCollector,
     wns::ldk::FunctionalUnit,
@@ -43,8 +48,26 @@ using namespace wimac::frame;
 
 DataCollector::DataCollector(wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config) :
     wns::ldk::fcf::CompoundCollector(config),
-    wns::ldk::CommandTypeSpecifier<wns::ldk::EmptyCommand>(fun)
+    wns::ldk::CommandTypeSpecifier<wns::ldk::EmptyCommand>(fun),
+    phaseStart_(0.0),
+    otherTXScheduler(NULL),
+    adaptiveTDD_(!config.isNone("adaptiveTDD")),
+    minDLTimeSlots_(0),
+    maxDLTimeSlots_(0),
+    ulDataCollector_(NULL),
+    errorModelling_(NULL)
 {
+    if (!config.isNone("batchErrorModelling"))
+        errorModellingName_ = config.get<std::string>("batchErrorModelling");
+
+    if (adaptiveTDD_)
+    {
+        minDLTimeSlots_ = config.get<int>("adaptiveTDD.minDLTimeSlots");
+        maxDLTimeSlots_ = config.get<int>("adaptiveTDD.maxDLTimeSlots");
+        ulSchedulerName_ = config.get<std::string>("adaptiveTDD.ulSchedulerName");
+        assure(minDLTimeSlots_ <= maxDLTimeSlots_, "minDLTimeSlots exceeds maxDLTimeSlots");
+    }
+
     if (!config.isNone("txScheduler"))
     {
         std::string txSchedulerName = config.get<std::string>("txScheduler.__plugin__");
@@ -83,7 +106,16 @@ DataCollector::DataCollector(const DataCollector& rhs) :
     wns::ldk::HasReceptor<wns::ldk::SingleReceptor>(rhs),
     wns::ldk::HasDeliverer<wns::ldk::SingleDeliverer>(rhs),
     wns::Cloneable<wimac::frame::DataCollector>(rhs),
-    wns::events::CanTimeout(rhs)
+    wns::events::CanTimeout(rhs),
+    phaseStart_(rhs.phaseStart_),
+    otherTXScheduler(rhs.otherTXScheduler),
+    adaptiveTDD_(rhs.adaptiveTDD_),
+    minDLTimeSlots_(rhs.minDLTimeSlots_),
+    maxDLTimeSlots_(rhs.maxDLTimeSlots_),
+    ulSchedulerName_(rhs.ulSchedulerName_),
+    ulDataCollector_(rhs.ulDataCollector_),
+    errorModellingName_(rhs.errorModellingName_),
+    errorModelling_(rhs.errorModelling_)
 {
     txScheduler.reset(dynamic_cast<wimac::scheduler::Interface*>
                       (dynamic_cast<wns::CloneableInterface*>
@@ -124,6 +156,18 @@ DataCollector::onFUNCreated()
 
     phyUser_ = getFUN()->findFriend<wimac::PhyUser*>("phyUser");
     assure( phyUser_, "PhyUser is not of type wimac::PhyUser");
+
+    if (adaptiveTDD_)
+    {
+        ulDataCollector_ = getFUN()->findFriend<DataCollector*>(ulSchedulerName_);
+        assure(ulDataCollector_, "Adaptive TDD needs the UL DataCollector");
+    }
+
+    if (!errorModellingName_.empty())
+    {
+        errorModelling_ = getFUN()->findFriend<wimac::ErrorModelling*>(errorModellingName_);
+        assure(errorModelling_, "Batch error evaluation needs a wimac::ErrorModelling");
+    }
 }
 
 void
@@ -137,25 +181,54 @@ DataCollector::doOnData(const wns::ldk::CompoundPtr& compound)
 
     assure(otherTXScheduler, "Need pointer to TX scheduler for other direction");
 
+    // broadcasts carry a time slot but are not HARQ protected
     if(phyCommand->magic.schedulingTimeSlot != NULL 
+        && phyCommand->peer.destination_ != NULL
         && otherTXScheduler->getHARQ() != NULL)
     {
-        assure(phyCommand->magic.schedulingTimeSlot
-            ->physicalResources[0].countScheduledCompounds() == 1, 
-                "We only support one PDU per resource");
-
         int beam = phyCommand->local.pAFunc_->beam_;
 
-        wimac::PhyUserCommand* shedPhyCommand = phyUser_->getCommand(
-            phyCommand->magic.schedulingTimeSlot
-                ->physicalResources[beam].scheduledCompoundsBegin()
-                    ->compoundPtr->getCommandPool());
+        wns::scheduler::PhysicalResourceBlock& prb =
+            phyCommand->magic.schedulingTimeSlot->physicalResources[beam];
+
+        assure(prb.hasScheduledCompounds(), "Received compound on an empty resource");
+
+        // The first compound of the resource identifies it, each received
+        // compound carries its own copy of the time slot
+        wns::ldk::CompoundPtr firstCompound = prb.scheduledCompoundsBegin()->compoundPtr;
+        PendingResource& pending = pendingResources_[firstCompound.getPtr()];
+
+        if (pending.receivedCompounds == 0)
+        {
+            pending.firstCompound = firstCompound;
+            pending.firstReception = wns::simulator::getEventScheduler()->getTime();
+        }
+        pending.receivedCompounds++;
+
+        if (pending.rxMeasurement == wns::service::phy::power::PowerMeasurementPtr()
+            || phyCommand->magic.rxMeasurement->getSINR() < pending.rxMeasurement->getSINR())
+        {
+            pending.rxMeasurement = phyCommand->magic.rxMeasurement;
+        }
+
+        if (pending.receivedCompounds < prb.countScheduledCompounds())
+            return;
+
+        wns::service::phy::power::PowerMeasurementPtr rxMeasurement = pending.rxMeasurement;
+        pendingResources_.erase(firstCompound.getPtr());
 
-        shedPhyCommand->magic.rxMeasurement = phyCommand->magic.rxMeasurement;
+        wns::scheduler::ScheduledCompoundsList::const_iterator compoundIt;
+        for (compoundIt = prb.scheduledCompoundsBegin();
+             compoundIt != prb.scheduledCompoundsEnd();
+             ++compoundIt)
+        {
+            phyUser_->getCommand(compoundIt->compoundPtr->getCommandPool())
+                ->magic.rxMeasurement = rxMeasurement;
+        }
 
         otherTXScheduler->getHARQ()->onTimeSlotReceived(phyCommand->magic.schedulingTimeSlot,
             wns::scheduler::harq::HARQInterface::TimeSlotInfo(
-            phyCommand->magic.rxMeasurement,
+            rxMeasurement,
             phyCommand->local.pAFunc_->subBand_));
    
         if(deliverReceivedEvent == wns::events::scheduler::IEventPtr())
@@ -165,12 +238,43 @@ DataCollector::doOnData(const wns::ldk::CompoundPtr& compound)
                     Utilities::getComputationalAccuracyFactor());
         }
     }
+    else if (errorModelling_ != NULL)
+    {
+        batch_.push_back(compound);
+
+        if(deliverBatchEvent_ == wns::events::scheduler::IEventPtr())
+        {
+            deliverBatchEvent_ = wns::simulator::getEventScheduler()->scheduleDelay(
+                boost::bind(&DataCollector::deliverBatch, this),
+                    Utilities::getComputationalAccuracyFactor());
+        }
+    }
     else
     { 
         getDeliverer()->getAcceptor(compound)->onData(compound);
     }
 }
 
+void
+DataCollector::deliverBatch()
+{
+    deliverBatchEvent_ = wns::events::scheduler::IEventPtr();
+
+    std::vector<wns::ldk::CompoundPtr> batch;
+    batch.swap(batch_);
+
+    errorModelling_->evaluate(batch);
+
+    if (errorModelling_->decidesEarly())
+        errorModelling_->decide(batch);
+
+    for (std::vector<wns::ldk::CompoundPtr>::iterator it = batch.begin();
+         it != batch.end(); ++it)
+    {
+        getDeliverer()->getAcceptor(*it)->onData(*it);
+    }
+}
+
 void
 DataCollector::deliverReceived()
 {
@@ -183,6 +287,8 @@ DataCollector::deliverReceived()
 
     wns::scheduler::harq::HARQInterface::DecodeStatusContainer::iterator it;
 
+    std::vector<wns::ldk::CompoundPtr> decoded;
+
     for (it = compounds.begin(); it!=compounds.end();++it)
     {
         if(it->first->harq.successfullyDecoded)
@@ -199,16 +305,21 @@ DataCollector::deliverReceived()
                     compoundIt != itPRB->scheduledCompoundsEnd();
                     ++compoundIt)
                 {
-                    wimac::PhyUserCommand* phyCommand = 
-                        phyUser_->getCommand(compoundIt->compoundPtr->getCommandPool());
-
-                    getDeliverer()->getAcceptor(compoundIt->compoundPtr)
-                        ->onData(compoundIt->compoundPtr);
+                    decoded.push_back(compoundIt->compoundPtr);
                 }
             }
         }
         it->first->physicalResources.clear();
     }
+
+    if (errorModelling_ != NULL)
+        errorModelling_->evaluate(decoded);
+
+    for (std::vector<wns::ldk::CompoundPtr>::iterator compound = decoded.begin();
+         compound != decoded.end(); ++compound)
+    {
+        getDeliverer()->getAcceptor(*compound)->onData(*compound);
+    }
 }
 
 void
@@ -229,11 +340,68 @@ DataCollector::doStartCollection(int)
     sched = getCurrentScheduler();
     if(sched != NULL)
     {
-        getCurrentScheduler()->setDuration(getMaximumDuration());
+        if (adaptiveTDD_ && getMode() == Sending)
+            adaptTDDSplit();
+
+        TimingControl* timingControl =
+            dynamic_cast<TimingControl*>(getFrameBuilder()->getTimingControl());
+
+        // The phase may have been moved for this frame
+        if (timingControl != NULL)
+            getCurrentScheduler()->setDuration(timingControl->getPhaseDuration(this));
+        else
+            getCurrentScheduler()->setDuration(getMaximumDuration());
+
         getCurrentScheduler()->startScheduling();
     }
 }
 
+void
+DataCollector::adaptTDDSplit()
+{
+    wimac::scheduler::Scheduler* dlScheduler =
+        dynamic_cast<wimac::scheduler::Scheduler*>(txScheduler.get());
+    wimac::scheduler::Scheduler* ulScheduler =
+        dynamic_cast<wimac::scheduler::Scheduler*>(ulDataCollector_->getRxScheduler());
+    TimingControl* timingControl =
+        dynamic_cast<TimingControl*>(getFrameBuilder()->getTimingControl());
+
+    assure(dlScheduler && ulScheduler, "Adaptive TDD needs wimac schedulers in both directions");
+    assure(timingControl, "Adaptive TDD needs the wimac TimingControl");
+    assure(dlScheduler->getSlotDuration() == ulScheduler->getSlotDuration(),
+           "Adaptive TDD needs equal DL and UL slot durations");
+
+    int configuredDLSlots = dlScheduler->getConfiguredNumberOfTimeSlots();
+    int totalSlots = configuredDLSlots + ulScheduler->getConfiguredNumberOfTimeSlots();
+
+    Bit dlBacklog = dlScheduler->getBacklog();
+    Bit ulBacklog = ulScheduler->getBacklog();
+
+    // Without any backlog the configured split is kept
+    int dlSlots = configuredDLSlots;
+    if (dlBacklog + ulBacklog > 0)
+        dlSlots = int(double(dlBacklog) / double(dlBacklog + ulBacklog) * totalSlots + 0.5);
+
+    dlSlots = std::max(minDLTimeSlots_, std::min(maxDLTimeSlots_, dlSlots));
+    dlSlots = std::max(0, std::min(totalSlots, dlSlots));
+
+    dlScheduler->setNumberOfTimeSlots(dlSlots);
+    ulScheduler->setNumberOfTimeSlots(totalSlots - dlSlots);
+
+    LOG_INFO(getFUN()->getName(), ": TDD split ", dlSlots, "/", totalSlots - dlSlots,
+             " for a backlog of ", dlBacklog, "/", ulBacklog, " bits");
+
+    // In lookahead mode the schedules of this frame were computed during
+    // the last one, the new split takes effect with the next schedules
+    int scheduledDLSlots = dlScheduler->getNumberOfTimeSlots();
+    assure(scheduledDLSlots + ulScheduler->getNumberOfTimeSlots() == totalSlots,
+           "DL and UL schedules of this frame use different TDD splits");
+
+    if (scheduledDLSlots != configuredDLSlots)
+        timingControl->movePhaseBoundary(this, ulDataCollector_,
+            (scheduledDLSlots - configuredDLSlots) * dlScheduler->getSlotDuration());
+}
+
 void
 DataCollector::doStart(int)
 {
@@ -241,6 +409,8 @@ DataCollector::doStart(int)
     sched = getCurrentScheduler();
     if(sched != NULL)
         getCurrentScheduler()->deliverSchedule(getConnector());
+
+    phaseStart_ = wns::simulator::getEventScheduler()->getTime();
     setTimeout( getMaximumDuration() );
 }
 
@@ -260,9 +430,30 @@ DataCollector::doIsAccepting(const wns::ldk::CompoundPtr& compound) const
 void
 DataCollector::onTimeout()
 {
+    removeStalePendingResources();
     getFrameBuilder()->finishedPhase( this );
 }
 
+void
+DataCollector::removeStalePendingResources()
+{
+    // Resources of which not all compounds arrived during an earlier phase
+    // will never be completed
+    PendingResourceMap::iterator it = pendingResources_.begin();
+    while (it != pendingResources_.end())
+    {
+        if (it->second.firstReception < phaseStart_)
+        {
+            LOG_INFO(getFUN()->getName(), ": ", getName(),
+                     " dropping incompletely received resource with ",
+                     it->second.receivedCompounds, " compounds");
+            pendingResources_.erase(it++);
+        }
+        else
+            ++it;
+    }
+}
+
 void
 DataCollector::finishCollection()
 {
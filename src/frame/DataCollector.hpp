@@ -27,9 +27,15 @@
 #define WIMAC_FRAME_DATACOLLECTOR_HPP
 
 #include <WNS/ldk/fcf/CompoundCollector.hpp>
+#include <WNS/service/phy/power/PowerMeasurement.hpp>
 #include <WIMAC/PhyUser.hpp>
 
+#include <map>
+#include <vector>
+
 namespace wimac {
+    class ErrorModelling;
+
     namespace scheduler {
         class Interface;
         class Scheduler;
@@ -80,16 +86,75 @@ namespace wimac {
                 return rxScheduler.get();
             }
 
+            /**
+             * @brief Name of the ErrorModelling evaluating the batches,
+             * empty if compounds are evaluated one by one.
+             */
+            const std::string&
+            getBatchErrorModellingName() const
+            {
+                return errorModellingName_;
+            }
+
             void
             deliverReceived();
 
+            /**
+             * @brief Deliver the compounds received at the same time after
+             * their PER has been evaluated in one batch.
+             */
+            void
+            deliverBatch();
+
         private:
 
             wimac::scheduler::Interface*
             getCurrentScheduler() const;
 
+            /**
+             * @brief Split the time slots shared by the DL and UL data
+             * phases according to the backlog of both directions.
+             *
+             * Only done by the sending DL DataCollector of the BS. The UTs
+             * follow the phase duration announced in the DL-MAP. With
+             * lookahead scheduling the phases follow the split the
+             * schedules of the frame were computed with, the new split is
+             * used by the next lookahead schedules.
+             */
+            void
+            adaptTDDSplit();
+
+            /**
+             * @brief Reception state of a HARQ protected resource block
+             * that carries more than one compound.
+             *
+             * HARQ is informed once all compounds of the resource have been
+             * received, using the worst measurement among them.
+             */
+            struct PendingResource
+            {
+                PendingResource() :
+                    receivedCompounds(0),
+                    firstReception(0.0)
+                {}
+
+                // keeps the key of pendingResources_ alive
+                wns::ldk::CompoundPtr firstCompound;
+                unsigned int receivedCompounds;
+                wns::service::phy::power::PowerMeasurementPtr rxMeasurement;
+                wns::simulator::Time firstReception;
+            };
+
+            typedef std::map<wns::ldk::Compound*, PendingResource> PendingResourceMap;
+
+            void
+            removeStalePendingResources();
+
             wns::events::scheduler::IEventPtr deliverReceivedEvent;
 
+            PendingResourceMap pendingResources_;
+            wns::simulator::Time phaseStart_;
+
             std::auto_ptr<wimac::scheduler::Interface> txScheduler;
             std::auto_ptr<wimac::scheduler::Interface> rxScheduler;
 
@@ -97,6 +162,19 @@ namespace wimac {
 
             /* For HARQ */
             wimac::scheduler::Interface* otherTXScheduler;
+
+            /* For the adaptive TDD split */
+            bool adaptiveTDD_;
+            int minDLTimeSlots_;
+            int maxDLTimeSlots_;
+            std::string ulSchedulerName_;
+            DataCollector* ulDataCollector_;
+
+            /* For the batch error evaluation */
+            std::string errorModellingName_;
+            wimac::ErrorModelling* errorModelling_;
+            std::vector<wns::ldk::CompoundPtr> batch_;
+            wns::events::scheduler::IEventPtr deliverBatchEvent_;
         };
     }
 }
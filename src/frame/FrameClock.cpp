@@ -0,0 +1,304 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/frame/FrameClock.hpp>
+#include <WIMAC/frame/TimingControl.hpp>
+#include <WIMAC/parameter/PHY.hpp>
+
+#include <WNS/simulator/ISimulator.hpp>
+#include <WNS/Assure.hpp>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace wimac::frame;
+
+FrameClock::FrameClock() :
+    frameDuration_(0.0),
+    clockStart_(0.0)
+{
+}
+
+void
+FrameClock::registerTimingControl(TimingControl* timingControl,
+                                  wns::simulator::Time frameStartupDelay)
+{
+    if (isRegistered(timingControl))
+        return;
+
+    wns::simulator::Time now = wns::simulator::getEventScheduler()->getTime();
+
+    if (registrations_.empty())
+    {
+        frameDuration_ = parameter::ThePHY::getInstance()->getFrameDuration();
+        clockStart_ = now;
+        if (hasPeriodicTimeoutSet())
+            cancelPeriodicTimeout();
+        startPeriodicTimeout(frameDuration_);
+    }
+
+    Registration registration;
+    registration.frameOffset = std::fmod(now - clockStart_, frameDuration_);
+    registration.activationOffset = registration.frameOffset + frameStartupDelay;
+    registration.registered = now;
+    registration.cellID = 0;
+    registrations_[timingControl] = registration;
+
+    subSlots_[registration.frameOffset].frameStarts.push_back(timingControl);
+    subSlots_[registration.activationOffset].activationStarts.push_back(timingControl);
+}
+
+void
+FrameClock::unregisterTimingControl(TimingControl* timingControl)
+{
+    cancelWakeup(timingControl);
+
+    RegistrationMap::iterator it = registrations_.find(timingControl);
+    if (it == registrations_.end())
+        return;
+
+    SubSlotMap::iterator frameSlot = subSlots_.find(it->second.frameOffset);
+    remove(frameSlot->second.frameStarts, timingControl);
+
+    SubSlotMap::iterator activationSlot = subSlots_.find(it->second.activationOffset);
+    remove(activationSlot->second.activationStarts, timingControl);
+
+    if (frameSlot->second.frameStarts.empty() && frameSlot->second.activationStarts.empty())
+        subSlots_.erase(frameSlot);
+
+    if (activationSlot != frameSlot
+        && activationSlot->second.frameStarts.empty()
+        && activationSlot->second.activationStarts.empty())
+        subSlots_.erase(activationSlot);
+
+    registrations_.erase(it);
+
+    if (registrations_.empty())
+        reset();
+}
+
+void
+FrameClock::reset()
+{
+    if (hasPeriodicTimeoutSet())
+        cancelPeriodicTimeout();
+
+    // events already scheduled for sub-slots and wake ups find no entries
+    subSlots_.clear();
+    registrations_.clear();
+    wakeups_.clear();
+    pendingWakeups_.clear();
+    idleCells_.clear();
+
+    frameDuration_ = 0.0;
+    clockStart_ = 0.0;
+}
+
+bool
+FrameClock::isRegistered(const TimingControl* timingControl) const
+{
+    return registrations_.find(timingControl) != registrations_.end();
+}
+
+void
+FrameClock::periodically()
+{
+    wns::simulator::Time now = wns::simulator::getEventScheduler()->getTime();
+
+    updateIdleCells();
+
+    // sub-slots are sorted by their offset
+    for (SubSlotMap::const_iterator it = subSlots_.begin(); it != subSlots_.end(); ++it)
+    {
+        if (it->first == 0.0)
+            onSubSlot(it->first);
+        else
+            wns::simulator::getEventScheduler()->schedule(
+                boost::bind(&FrameClock::onSubSlot, this, it->first), now + it->first);
+    }
+}
+
+void
+FrameClock::updateIdleCells()
+{
+    idleCells_.clear();
+
+    bool skipping = false;
+    for (RegistrationMap::const_iterator it = registrations_.begin(); it != registrations_.end(); ++it)
+        skipping = skipping || it->first->skipsIdleFrames();
+
+    if (!skipping)
+        return;
+
+    // A cell is idle only if every one of its stations is
+    std::set<unsigned int> busyCells;
+
+    for (RegistrationMap::iterator it = registrations_.begin(); it != registrations_.end(); ++it)
+    {
+        const TimingControl* timingControl = it->first;
+        it->second.cellID = timingControl->getCellID();
+
+        // Unassociated stations need the frames of all cells to associate
+        if (it->second.cellID == 0)
+        {
+            idleCells_.clear();
+            return;
+        }
+
+        if (busyCells.find(it->second.cellID) != busyCells.end())
+            continue;
+
+        if (timingControl->skipsIdleFrames() && timingControl->isIdle())
+            idleCells_.insert(it->second.cellID);
+        else
+        {
+            busyCells.insert(it->second.cellID);
+            idleCells_.erase(it->second.cellID);
+        }
+    }
+}
+
+bool
+FrameClock::isIdle(const TimingControl* timingControl) const
+{
+    RegistrationMap::const_iterator it = registrations_.find(timingControl);
+    if (it == registrations_.end() || it->second.cellID == 0)
+        return false;
+
+    return idleCells_.find(it->second.cellID) != idleCells_.end();
+}
+
+void
+FrameClock::onSubSlot(wns::simulator::Time offset)
+{
+    SubSlotMap::iterator it = subSlots_.find(offset);
+    if (it == subSlots_.end())
+        return;
+
+    wns::simulator::Time now = wns::simulator::getEventScheduler()->getTime();
+
+    // Work on copies, TimingControls may unregister while being called
+    std::vector<TimingControl*> frameStarts = it->second.frameStarts;
+    std::vector<TimingControl*> activationStarts = it->second.activationStarts;
+
+    for (std::vector<TimingControl*>::iterator tc = frameStarts.begin();
+         tc != frameStarts.end(); ++tc)
+    {
+        RegistrationMap::const_iterator registration = registrations_.find(*tc);
+
+        // the first frame starts one frame duration after registration
+        if (registration != registrations_.end() && registration->second.registered < now)
+            (*tc)->periodically();
+    }
+
+    for (std::vector<TimingControl*>::iterator tc = activationStarts.begin();
+         tc != activationStarts.end(); ++tc)
+    {
+        RegistrationMap::const_iterator registration = registrations_.find(*tc);
+
+        // activations of a frame that started before registration are skipped
+        if (registration != registrations_.end()
+            && registration->second.registered
+               < now - (registration->second.activationOffset - registration->second.frameOffset))
+            (*tc)->startProcessingActivations();
+    }
+}
+
+void
+FrameClock::wakeupAt(TimingControl* timingControl, wns::simulator::Time at)
+{
+    assure(!hasWakeup(timingControl), "TimingControl already has a pending wake up");
+    assure(at >= wns::simulator::getEventScheduler()->getTime(), "Cannot wake up in the past");
+
+    WakeupMap::iterator it = wakeups_.find(at);
+    if (it == wakeups_.end())
+    {
+        it = wakeups_.insert(std::make_pair(at, std::vector<TimingControl*>())).first;
+        wns::simulator::getEventScheduler()->schedule(
+            boost::bind(&FrameClock::onWakeup, this, at), at);
+    }
+
+    it->second.push_back(timingControl);
+    pendingWakeups_[timingControl] = at;
+}
+
+void
+FrameClock::cancelWakeup(TimingControl* timingControl)
+{
+    PendingWakeupMap::iterator pending = pendingWakeups_.find(timingControl);
+    if (pending == pendingWakeups_.end())
+        return;
+
+    WakeupMap::iterator it = wakeups_.find(pending->second);
+    assure(it != wakeups_.end(), "Pending wake up without entry");
+
+    remove(it->second, timingControl);
+    if (it->second.empty())
+        wakeups_.erase(it);
+
+    pendingWakeups_.erase(pending);
+}
+
+bool
+FrameClock::hasWakeup(const TimingControl* timingControl) const
+{
+    return pendingWakeups_.find(timingControl) != pendingWakeups_.end();
+}
+
+void
+FrameClock::onWakeup(wns::simulator::Time at)
+{
+    WakeupMap::iterator it = wakeups_.find(at);
+
+    // all wake ups for this point in time have been cancelled
+    if (it == wakeups_.end())
+        return;
+
+    std::vector<TimingControl*> timingControls;
+    timingControls.swap(it->second);
+    wakeups_.erase(it);
+
+    for (std::vector<TimingControl*>::iterator tc = timingControls.begin();
+         tc != timingControls.end(); ++tc)
+    {
+        pendingWakeups_.erase(*tc);
+    }
+
+    for (std::vector<TimingControl*>::iterator tc = timingControls.begin();
+         tc != timingControls.end(); ++tc)
+    {
+        (*tc)->onTimeout();
+    }
+}
+
+void
+FrameClock::remove(std::vector<TimingControl*>& timingControls, const TimingControl* timingControl)
+{
+    timingControls.erase(
+        std::remove(timingControls.begin(), timingControls.end(), timingControl),
+        timingControls.end());
+}
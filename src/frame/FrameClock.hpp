@@ -0,0 +1,163 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_FRAME_FRAMECLOCK_HPP
+#define WIMAC_FRAME_FRAMECLOCK_HPP
+
+#include <WNS/Singleton.hpp>
+#include <WNS/events/PeriodicTimeout.hpp>
+#include <WNS/simulator/Time.hpp>
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace wimac { namespace frame {
+
+        class TimingControl;
+
+        /**
+         * @brief Frame clock shared by the TimingControls of all stations.
+         *
+         * The clock fires once per frame. A TimingControl registers with the
+         * offset of its frame start relative to the clock and its
+         * frameStartupDelay. Both offsets are kept as sorted sub-slots, so
+         * each distinct offset costs one event per frame no matter how many
+         * stations use it.
+         *
+         * Phase timeouts of the TimingControls are coalesced the same way:
+         * all TimingControls waiting for the same point in time are woken up
+         * by a single event.
+         *
+         * At each tick the clock determines the idle cells: cells in which
+         * all stations skip idle frames and none holds data. Their stations
+         * skip the activations of the frame.
+         *
+         * The clock is a singleton and outlives the stations of a
+         * simulation. TimingControls unregister when they are stopped at
+         * shutdown or destroyed, the clock resets itself once the last one
+         * has left.
+         */
+        class FrameClock :
+            public wns::events::PeriodicTimeout
+        {
+        public:
+            FrameClock();
+
+            /**
+             * @brief Start delivering frame starts to timingControl.
+             *
+             * The first frame of timingControl starts one frame duration
+             * after registration, its activations frameStartupDelay later.
+             */
+            void
+            registerTimingControl(TimingControl* timingControl,
+                                  wns::simulator::Time frameStartupDelay);
+
+            void
+            unregisterTimingControl(TimingControl* timingControl);
+
+            bool
+            isRegistered(const TimingControl* timingControl) const;
+
+            /**
+             * @brief Drop all registrations and wake ups and stop the clock.
+             */
+            void
+            reset();
+
+            /**
+             * @brief Call TimingControl::onTimeout at the absolute time at.
+             *
+             * A TimingControl has at most one pending wake up.
+             */
+            void
+            wakeupAt(TimingControl* timingControl, wns::simulator::Time at);
+
+            void
+            cancelWakeup(TimingControl* timingControl);
+
+            bool
+            hasWakeup(const TimingControl* timingControl) const;
+
+            /**
+             * @brief True if the cell of timingControl was idle at the
+             * start of the current frame.
+             */
+            bool
+            isIdle(const TimingControl* timingControl) const;
+
+            // PeriodicTimeout interface
+            void
+            periodically();
+
+        private:
+            struct SubSlot
+            {
+                std::vector<TimingControl*> frameStarts;
+                std::vector<TimingControl*> activationStarts;
+            };
+
+            struct Registration
+            {
+                wns::simulator::Time frameOffset;
+                wns::simulator::Time activationOffset;
+                wns::simulator::Time registered;
+                /** @brief Cell at the start of the current frame */
+                unsigned int cellID;
+            };
+
+            typedef std::map<wns::simulator::Time, SubSlot> SubSlotMap;
+            typedef std::map<const TimingControl*, Registration> RegistrationMap;
+            typedef std::map<wns::simulator::Time, std::vector<TimingControl*> > WakeupMap;
+            typedef std::map<const TimingControl*, wns::simulator::Time> PendingWakeupMap;
+
+            void
+            onSubSlot(wns::simulator::Time offset);
+
+            void
+            updateIdleCells();
+
+            void
+            onWakeup(wns::simulator::Time at);
+
+            static void
+            remove(std::vector<TimingControl*>& timingControls, const TimingControl* timingControl);
+
+            SubSlotMap subSlots_;
+            RegistrationMap registrations_;
+            WakeupMap wakeups_;
+            PendingWakeupMap pendingWakeups_;
+            std::set<unsigned int> idleCells_;
+
+            wns::simulator::Time frameDuration_;
+            wns::simulator::Time clockStart_;
+        };
+
+        typedef wns::SingletonHolder<FrameClock> TheFrameClock;
+    }
+}
+
+#endif
@@ -78,32 +78,22 @@ void FrameHeadCollector::doStart(int mode)
     switch (mode) {
     case CompoundCollector::Sending:
     {
-        wns::ldk::CompoundPtr compound (
-            new wns::ldk::Compound( getFUN()->getProxy()->createCommandPool() ) );
+        if ( template_ == wns::ldk::CompoundPtr() )
+            createTemplate();
 
-        FrameHeadCommand* command = activateCommand( compound->getCommandPool() );
-        command->peer.baseStationID = layer_->getID();
+        wns::ldk::CompoundPtr compound = template_->copy();
+
+        FrameHeadCommand* command = getCommand( compound->getCommandPool() );
         command->local.duration =
             getCurrentDuration() - Utilities::getComputationalAccuracyFactor();
 
-        PhyUserCommand* phyCommand = dynamic_cast<PhyUserCommand*>(
-            getFUN()->getProxy()->activateCommand( compound->getCommandPool(),
-                                                   phyUser_ ) );
-        phyCommand->peer.destination_ = 0;
+        PhyUserCommand* phyCommand = phyUser_->getCommand( compound->getCommandPool() );
         phyCommand->peer.cellID_ = layer_->getCellID();
-        phyCommand->peer.source_ = layer_->getNode();
-        assureNotNull(phyMode_.getPtr());
-        phyCommand->peer.phyModePtr = phyMode_;
-        phyCommand->magic.sourceComponent_ = layer_;
-        phyCommand->magic.frameHead_ = true;
 
         wns::simulator::Time now = wns::simulator::getEventScheduler()->getTime();
-        phyCommand->local.pAFunc_.reset
-            ( new BroadcastPhyAccessFunc);
         phyCommand->local.pAFunc_->transmissionStart_ = now;
         phyCommand->local.pAFunc_->transmissionStop_ = now + command->local.duration
              - Utilities::getComputationalAccuracyFactor();
-        phyCommand->local.pAFunc_->phyMode_ = phyMode_;
 
         assure( command->local.duration <= this->getMaximumDuration(),
                 "FrameHeadWriter: PDU overun the maximum duration of the frame phase!");
@@ -123,6 +113,30 @@ void FrameHeadCollector::doStart(int mode)
     }
 }
 
+void
+FrameHeadCollector::createTemplate()
+{
+    template_ = wns::ldk::CompoundPtr(
+        new wns::ldk::Compound( getFUN()->getProxy()->createCommandPool() ) );
+
+    FrameHeadCommand* command = activateCommand( template_->getCommandPool() );
+    command->peer.baseStationID = layer_->getID();
+
+    PhyUserCommand* phyCommand = dynamic_cast<PhyUserCommand*>(
+        getFUN()->getProxy()->activateCommand( template_->getCommandPool(),
+                                               phyUser_ ) );
+    phyCommand->peer.destination_ = 0;
+    phyCommand->peer.source_ = layer_->getNode();
+    assureNotNull(phyMode_.getPtr());
+    phyCommand->peer.phyModePtr = phyMode_;
+    phyCommand->magic.sourceComponent_ = layer_;
+    phyCommand->magic.frameHead_ = true;
+
+    phyCommand->local.pAFunc_.reset
+        ( new BroadcastPhyAccessFunc);
+    phyCommand->local.pAFunc_->phyMode_ = phyMode_;
+}
+
 void
 FrameHeadCollector::onTimeout()
 {
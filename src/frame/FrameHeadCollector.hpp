@@ -95,11 +95,23 @@ namespace wimac { namespace frame {
             void onTimeout();
 
         private:
+            /**
+             * @brief Build the compound that is copied for each frame
+             * head.
+             */
+            void createTemplate();
+
             wimac::Component* layer_;
             wimac::PhyUser* phyUser_;
             wimac::service::ConnectionManager* connectionManager_;
             wimac::service::IChannelQualityObserver* channelQualityObserver_;
             wns::SmartPtr<const wns::service::phy::phymode::PhyModeInterface> phyMode_;
+
+            /**
+             * @brief Frame head with all fields set that do not change from
+             * frame to frame.
+             */
+            wns::ldk::CompoundPtr template_;
         };
     }
 }
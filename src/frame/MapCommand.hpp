@@ -29,6 +29,9 @@
 
 #include <WNS/ldk/Command.hpp>
 #include <WNS/CandI.hpp>
+#include <WNS/simulator/Bit.hpp>
+
+#include <WIMAC/scheduler/GrantIndex.hpp>
 
 namespace wimac {
 
@@ -39,10 +42,14 @@ namespace wimac {
         struct {
             wns::simulator::Time mapDuration;
             size_t numBursts;
+            /** @brief Size of the MAP including all sub-MAPs */
+            Bit mapSize;
         } local;
         struct {
             //wns::scheduler::MapInfoCollectionPtr mapInfo;
             wns::scheduler::SchedulingMapPtr schedulingMap;
+            /** @brief Grants of the UL-MAP by user */
+            wimac::scheduler::GrantIndexPtr grantIndex;
             wns::simulator::Time phaseDuration;
             int baseStationID;
         } peer;
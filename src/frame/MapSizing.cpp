@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/frame/MapSizing.hpp>
+#include <WIMAC/parameter/PHY.hpp>
+
+#include <WNS/service/phy/phymode/PhyModeInterface.hpp>
+#include <WNS/Exception.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace wimac::frame;
+
+namespace {
+    bool
+    lowerDataRate(const wns::service::phy::phymode::PhyModeInterfacePtr& lhs,
+                  const wns::service::phy::phymode::PhyModeInterfacePtr& rhs)
+    {
+        return lhs->getDataRate() < rhs->getDataRate();
+    }
+}
+
+MapSizing::MapSizing(const wns::pyconfig::View& config,
+                     wns::service::phy::phymode::PhyModeInterfacePtr basePhyMode) :
+    format_(Normal),
+    headerBits_(parameter::ThePHY::getInstance()->getMapBase()),
+    ieBits_(parameter::ThePHY::getInstance()->getIE()),
+    subMapHeaderBits_(config.get<Bit>("subMapHeaderBits")),
+    subMapPointerBits_(config.get<Bit>("subMapPointerBits")),
+    basePhyMode_(basePhyMode)
+{
+    std::string format = config.get<std::string>("format");
+
+    if (format == "normal")
+        format_ = Normal;
+    else if (format == "compressed")
+        format_ = Compressed;
+    else if (format == "subMap")
+        format_ = SubMap;
+    else
+        throw wns::Exception("Unknown MAP format: " + format);
+
+    if (format_ == Compressed)
+    {
+        headerBits_ = config.get<Bit>("compressedHeaderBits");
+        ieBits_ = config.get<Bit>("compressedIEBits");
+    }
+
+    for (int i = 0; i < config.len("subMapPhyModes"); ++i)
+    {
+        subMapPhyModes_.push_back(
+            wns::service::phy::phymode::PhyModeInterfacePtr(
+                wns::service::phy::phymode::createPhyMode(
+                    config.getView("subMapPhyModes", i))));
+    }
+    std::sort(subMapPhyModes_.begin(), subMapPhyModes_.end(), lowerDataRate);
+
+    if (format_ == SubMap && subMapPhyModes_.empty())
+        throw wns::Exception("MAP format subMap requires at least one sub-MAP PhyMode");
+}
+
+MapSizing::MapParts
+MapSizing::getParts(const wimac::scheduler::Scheduler::Bursts& bursts) const
+{
+    // parts[0] is the base MAP, parts[i + 1] the sub-MAP of subMapPhyModes_[i]
+    MapParts parts(1 + (format_ == SubMap ? subMapPhyModes_.size() : 0));
+    parts[0].phyMode = basePhyMode_;
+    parts[0].bits = headerBits_;
+
+    for (std::size_t i = 1; i < parts.size(); ++i)
+        parts[i].phyMode = subMapPhyModes_[i - 1];
+
+    for (wimac::scheduler::Scheduler::Bursts::const_iterator it = bursts.begin();
+         it != bursts.end(); ++it)
+    {
+        std::size_t part = 0;
+
+        if (format_ == SubMap && it->phyMode != wns::service::phy::phymode::PhyModeInterfacePtr())
+        {
+            // the most efficient sub-MAP the user of the burst can decode
+            for (std::size_t i = subMapPhyModes_.size(); i > 0; --i)
+            {
+                if (subMapPhyModes_[i - 1]->getDataRate() <= it->phyMode->getDataRate())
+                {
+                    part = i;
+                    break;
+                }
+            }
+        }
+
+        parts[part].bits += ieBits_;
+    }
+
+    for (std::size_t i = 1; i < parts.size(); ++i)
+    {
+        if (parts[i].bits > 0)
+        {
+            parts[i].bits += subMapHeaderBits_;
+            parts[0].bits += subMapPointerBits_;
+        }
+    }
+
+    return parts;
+}
+
+Bit
+MapSizing::getSize(const wimac::scheduler::Scheduler::Bursts& bursts) const
+{
+    MapParts parts = getParts(bursts);
+
+    Bit size = 0;
+    for (MapParts::const_iterator it = parts.begin(); it != parts.end(); ++it)
+        size += it->bits;
+
+    return size;
+}
+
+wns::simulator::Time
+MapSizing::getDuration(const wimac::scheduler::Scheduler::Bursts& bursts) const
+{
+    MapParts parts = getParts(bursts);
+
+    int subChannels = parameter::ThePHY::getInstance()->getSubCahnnels();
+    wns::simulator::Time symbolDuration = parameter::ThePHY::getInstance()->getSymbolDuration();
+
+    wns::simulator::Time duration = 0.0;
+    for (MapParts::const_iterator it = parts.begin(); it != parts.end(); ++it)
+        duration += it->bits / (it->phyMode->getDataRate() * subChannels);
+
+    // at least one symbol
+    int symbols = std::max(1, int(ceil(duration / symbolDuration - 1e-9)));
+    return symbols * symbolDuration;
+}
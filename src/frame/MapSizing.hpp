@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_FRAME_MAPSIZING_HPP
+#define WIMAC_FRAME_MAPSIZING_HPP
+
+#include <WNS/pyconfig/View.hpp>
+#include <WNS/service/phy/phymode/PhyModeInterface.hpp>
+#include <WNS/simulator/Bit.hpp>
+#include <WNS/simulator/Time.hpp>
+
+#include <WIMAC/scheduler/Scheduler.hpp>
+
+#include <vector>
+
+namespace wimac { namespace frame {
+
+        /**
+         * @brief Computes size and duration of a DL-MAP or UL-MAP from the
+         * bursts of the current schedule.
+         *
+         * Three formats are supported:
+         * \li normal: mapBase header bits plus ie bits per burst (see
+         *   parameter::PHY), sent with the PhyMode of the MAP collector
+         * \li compressed: reduced header and IE sizes
+         * \li subMap: bursts whose PhyMode allows it are moved into a
+         *   sub-MAP sent with a more efficient PhyMode. The base MAP carries
+         *   one pointer per used sub-MAP.
+         *
+         * The MAP is spread over all subchannels and rounded up to full
+         * symbols.
+         */
+        class MapSizing
+        {
+        public:
+            enum Format {
+                Normal,
+                Compressed,
+                SubMap
+            };
+
+            MapSizing(const wns::pyconfig::View& config,
+                      wns::service::phy::phymode::PhyModeInterfacePtr basePhyMode);
+
+            /**
+             * @brief Total size of the MAP including all sub-MAPs.
+             */
+            Bit
+            getSize(const wimac::scheduler::Scheduler::Bursts& bursts) const;
+
+            /**
+             * @brief Air time of the MAP including all sub-MAPs.
+             */
+            wns::simulator::Time
+            getDuration(const wimac::scheduler::Scheduler::Bursts& bursts) const;
+
+        private:
+            struct MapPart
+            {
+                MapPart() : bits(0) {}
+
+                wns::service::phy::phymode::PhyModeInterfacePtr phyMode;
+                Bit bits;
+            };
+            typedef std::vector<MapPart> MapParts;
+
+            MapParts
+            getParts(const wimac::scheduler::Scheduler::Bursts& bursts) const;
+
+            Format format_;
+            Bit headerBits_;
+            Bit ieBits_;
+            Bit subMapHeaderBits_;
+            Bit subMapPointerBits_;
+
+            wns::service::phy::phymode::PhyModeInterfacePtr basePhyMode_;
+
+            /** @brief Sorted by ascending data rate */
+            std::vector<wns::service::phy::phymode::PhyModeInterfacePtr> subMapPhyModes_;
+        };
+    }
+}
+
+#endif
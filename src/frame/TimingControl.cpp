@@ -36,7 +36,13 @@
 #include <WNS/probe/bus/ContextCollector.hpp>
 #include <boost/bind.hpp>
 
+#include <WIMAC/ACKSwitch.hpp>
+#include <WIMAC/Component.hpp>
 #include <WIMAC/Logger.hpp>
+#include <WIMAC/Utilities.hpp>
+#include <WIMAC/frame/DataCollector.hpp>
+#include <WIMAC/frame/FrameClock.hpp>
+#include <WIMAC/scheduler/Scheduler.hpp>
 #include <WIMAC/parameter/PHY.hpp>
 
 STATIC_FACTORY_REGISTER_WITH_CREATOR(
@@ -47,32 +53,18 @@ STATIC_FACTORY_REGISTER_WITH_CREATOR(
 
 using namespace wimac::frame;
 
-namespace wimac { namespace frame {
-
-
-        class TriggerActivationStart
-        {
-        public:
-            TriggerActivationStart(TimingControl* timingControl) :
-                timingControl_(timingControl) {}
-
-            void operator()()
-            {
-                timingControl_->startProcessingActivations();
-            }
-
-        private:
-            TimingControl* timingControl_;
-        };
-    }
-}
-
 TimingControl::TimingControl( wns::ldk::fcf::FrameBuilder* fb, const wns::pyconfig::View& config) :
     wns::ldk::fcf::TimingControlInterface(),
+    active_(0),
     frameBuilder_(fb),
     running_(false),
     config_(config),
-    frameStartupDelay_(config.get<wns::simulator::Time>("frameStartupDelay"))
+    frameStartupDelay_(config.get<wns::simulator::Time>("frameStartupDelay")),
+    elasticPhases_(config.get<bool>("elasticPhases")),
+    skipIdleFrames_(config.get<bool>("skipIdleFrames")),
+    sleeping_(false),
+    frameStartTime_(0.0),
+    activationStartTime_(0.0)
 {
     assure( config.knows("activations"),
             "Activations are not specified in TimingControl" );
@@ -86,13 +78,17 @@ TimingControl::TimingControl( wns::ldk::fcf::FrameBuilder* fb, const wns::pyconf
 
 }
 
+TimingControl::~TimingControl()
+{
+    TheFrameClock::getInstance()->unregisterTimingControl(this);
+}
+
 void TimingControl::start()
 {
-    activeCC_ = activations_.end();
+    active_ = schedule_.size();
     running_ = true;
 
-    if ( !this->hasPeriodicTimeoutSet() )
-        this->startPeriodicTimeout(parameter::ThePHY::getInstance()->getFrameDuration());
+    TheFrameClock::getInstance()->registerTimingControl(this, frameStartupDelay_);
 
     // to allow first frame to begin immediately do:
     // this->periodically();
@@ -101,14 +97,13 @@ void TimingControl::start()
 void TimingControl::pause()
 {
     running_ = false;
-    activeCC_ = activations_.end();
+    active_ = schedule_.size();
 }
 
 void TimingControl::stop()
 {
-    this->cancelPeriodicTimeout();
-    this->cancelTimeout();
-    activeCC_ = activations_.end();
+    TheFrameClock::getInstance()->unregisterTimingControl(this);
+    active_ = schedule_.size();
     running_ = false;
 }
 
@@ -120,23 +115,62 @@ void TimingControl::configure()
 
 void TimingControl::onFUNCreated()
 {
-    double sumDuration = 0.0;
+    compileSchedule();
+    validateSchedule();
+
+    active_ = schedule_.size();
+}
+
+void
+TimingControl::compileSchedule()
+{
+    schedule_.clear();
+    schedule_.reserve(config_.len("activations"));
+
+    wns::simulator::Time offset = 0.0;
 
     for ( int i = 0; i < config_.len("activations"); ++i ) {
         wns::pyconfig::View activationConfig( config_, "activations", i );
 
-        int mode = activationConfig.get<int>("mode.mode");
-        double duration = activationConfig.get<double>("duration");
-        int action = activationConfig.get<int>("action.action");
+        CompiledActivation entry;
+        entry.mode = activationConfig.get<int>("mode.mode");
+        entry.action = activationConfig.get<int>("action.action");
+        entry.duration = activationConfig.get<double>("duration");
+        entry.compoundCollector = NULL;
 
-        wns::ldk::fcf::CompoundCollector* compoundCollector;
+        switch ( entry.action ) {
+        case TimingControl::Start:
+            entry.handler = &TimingControl::doStart;
+            break;
+        case TimingControl::StartCollection:
+            entry.handler = &TimingControl::doStartCollection;
+            break;
+        case TimingControl::FinishCollection:
+            entry.handler = &TimingControl::doFinishCollection;
+            break;
+        case TimingControl::Pause:
+            entry.handler = &TimingControl::doPause;
+            break;
+        default:
+        {
+            std::stringstream ss;
+            ss << "Unknown activation " << entry.action << " in Timing Control of "
+               << getFrameBuilder()->getFUN()->getName();
+            throw wns::Exception(ss.str());
+        }
+        }
+
+        // only these actions are really time consuming
+        entry.timed = (entry.action == TimingControl::Start
+                       || entry.action == TimingControl::Pause);
 
-        if(action != TimingControl::Pause){
+        if(entry.action != TimingControl::Pause){
 
             std::string ccName = activationConfig.get<std::string>("compoundCollector");
 
-            compoundCollector = ( getFrameBuilder()->getFUN()->
-                                  findFriend<wns::ldk::fcf::CompoundCollector*>(ccName));
+            wns::ldk::fcf::CompoundCollector* compoundCollector =
+                getFrameBuilder()->getFUN()->
+                findFriend<wns::ldk::fcf::CompoundCollector*>(ccName);
 
             if (!compoundCollector) {
                 std::stringstream ss;
@@ -146,50 +180,66 @@ void TimingControl::onFUNCreated()
             }
 
             compoundCollector->setFrameBuilder( getFrameBuilder() );
+            entry.compoundCollector = compoundCollector;
 
             LOG_INFO( getFrameBuilder()->getFUN()->getName(),
                       ": new activation entry for CC: ",
                       compoundCollector->getName(), ", with mode: ",
-                      wns::ldk::fcf::CompoundCollector::mode2String(mode),
-                      ", action: ", action, ", and duration: ", duration);
+                      wns::ldk::fcf::CompoundCollector::mode2String(entry.mode),
+                      ", action: ", entry.action, ", and duration: ", entry.duration);
         }
-        else if(action == TimingControl::Pause){
+        else {
             // there is no compound collector needed for Pause Activations
-            compoundCollector = NULL;
-
             LOG_INFO( getFrameBuilder()->getFUN()->getName(),
                       ": new Pause activation entry with mode: ",
-                      wns::ldk::fcf::CompoundCollector::mode2String(mode),
-                      ", action: ", action, ", and duration: ", duration);
+                      wns::ldk::fcf::CompoundCollector::mode2String(entry.mode),
+                      ", action: ", entry.action, ", and duration: ", entry.duration);
         }
 
-        ActivationEntry entry;
-        entry.mode = mode;
-        entry.action = action;
-        entry.compoundCollector = compoundCollector;
-        entry.duration = duration;
+        entry.offset = offset;
+        if (entry.timed)
+            offset += entry.duration;
 
-        if(action && (action == TimingControl::Start || action == TimingControl::Pause)){
-            // only these actions are really time consuming
-            sumDuration += duration;
-        }
+        schedule_.push_back( entry );
+    }
 
-        activations_.push_back( entry );
+    offsetShift_.assign(schedule_.size(), 0.0);
+    durationShift_.assign(schedule_.size(), 0.0);
+}
 
-    }
-    LOG_INFO( getFrameBuilder()->getFUN()->getName(),  " ", activations_.size(),
+void
+TimingControl::validateSchedule() const
+{
+    wns::simulator::Time frameDuration = parameter::ThePHY::getInstance()->getFrameDuration();
+    wns::simulator::Time scheduleDuration = getScheduleDuration();
+
+    LOG_INFO( getFrameBuilder()->getFUN()->getName(),  " ", schedule_.size(),
               " activations registered at timing control, sum duration: ",
-              sumDuration, ", frame duration is: ",
-              parameter::ThePHY::getInstance()->getFrameDuration());
+              scheduleDuration, ", frame duration is: ", frameDuration);
 
-    LOG_INFO( "difference is ",
-              parameter::ThePHY::getInstance()->getFrameDuration() - sumDuration );
+    LOG_INFO( "difference is ", frameDuration - scheduleDuration );
 
-    assure(sumDuration <= parameter::ThePHY::getInstance()->getFrameDuration(),
-           "the sum of all phases does not fit into the frame duration");
+    if (scheduleDuration > frameDuration)
+    {
+        std::stringstream ss;
+        ss << "The activations of " << getFrameBuilder()->getFUN()->getName()
+           << " need " << scheduleDuration
+           << "s, this does not fit into the frame duration of "
+           << frameDuration << "s";
+        throw wns::Exception(ss.str());
+    }
+}
 
-    activeCC_ = activations_.end();
-    //timeoutIsForMe = activations_.end();
+wns::simulator::Time
+TimingControl::getScheduleDuration() const
+{
+    for (CompiledSchedule::const_reverse_iterator it = schedule_.rbegin();
+         it != schedule_.rend(); ++it)
+    {
+        if (it->timed)
+            return it->offset + it->duration;
+    }
+    return 0.0;
 }
 
 
@@ -199,15 +249,7 @@ void TimingControl::finishedPhase(wns::ldk::fcf::CompoundCollectorInterface* col
 void TimingControl::finishedPhase(wns::ldk::fcf::CompoundCollectorInterface*)
 #endif
 {
-    assure(activeCC_->compoundCollector == collector,
-           "An inactive compound collector has reported to have finished.");
-
-    //assure(timeoutIsForMe == activeCC_, "current timeout is not right");
-
-    assure(this->hasTimeoutSet(),
-           "the current phase (the last one?) finished after the final phase!?");
-
-    if ( activeCC_ == activations_.end() )
+    if ( active_ >= schedule_.size() )
     {
         std::stringstream ss;
         ss << "timing inconsistency" << std::endl;
@@ -216,11 +258,27 @@ void TimingControl::finishedPhase(wns::ldk::fcf::CompoundCollectorInterface*)
         throw wns::Exception( ss.str() );
     }
 
+    assure(schedule_[active_].compoundCollector == collector,
+           "An inactive compound collector has reported to have finished.");
+
+    assure(this->hasTimeoutSet(),
+           "the current phase (the last one?) finished after the final phase!?");
+
     LOG_INFO( getFrameBuilder()->getFUN()->getLayer()->getName(), " current phase has finished");
 
-    //if you want that the phases start subsequently do:
-    // this->cancelTimeout();
-    // this->onTimeout();
+    if ( !elasticPhases_ )
+        return;
+
+    // Let the next phase start right away, it ends at its scheduled time
+    // and thereby grows into the freed time
+    wns::simulator::Time now = wns::simulator::getEventScheduler()->getTime();
+    if ( now < getEnd(schedule_[active_]) - Utilities::getComputationalAccuracyFactor() )
+    {
+        LOG_INFO( getFrameBuilder()->getFUN()->getLayer()->getName(),
+                  " phase finished ", getEnd(schedule_[active_]) - now, "s early");
+        TheFrameClock::getInstance()->cancelWakeup(this);
+        onTimeout();
+    }
 }
 
 void
@@ -231,29 +289,44 @@ TimingControl::periodically()
 
     frameStartTime_ = wns::simulator::getEventScheduler()->getTime();
 
-    // Only continue if running == true
-    if ( !running_ )
-        return;
-
-    TriggerActivationStart event (this);
-
-    wns::simulator::getEventScheduler()
-        ->schedule(event, frameStartTime_ + frameStartupDelay_ );
+    // the FrameClock starts the activations frameStartupDelay_ later
 }
 
 void
 TimingControl::startProcessingActivations()
 {
+    // Only continue if running == true
+    if ( !running_ )
+        return;
+
     // Frame duration ends before last timing node is called
-    if ( activeCC_ != activations_.end())
+    if ( active_ < schedule_.size() )
     {
         LOG_WARN( getFrameBuilder()->getFUN()->getLayer()->getName(),
                   ": FrameBuilder has not yet finished current frame");
+        TheFrameClock::getInstance()->cancelWakeup(this);
+    }
+
+    if ( skipIdleFrames_ && TheFrameClock::getInstance()->isIdle(this) )
+    {
+        LOG_INFO( getFrameBuilder()->getFUN()->getName(), ": Skipping idle frame");
+        active_ = schedule_.size();
+        return;
+    }
+
+    if ( sleeping_ )
+    {
+        LOG_INFO( getFrameBuilder()->getFUN()->getName(), ": Sleeping, skipping frame");
+        active_ = schedule_.size();
+        return;
     }
 
     LOG_INFO( getFrameBuilder()->getFUN()->getName(),  ": Starting Frame");
 
-    activeCC_ = activations_.begin();
+    activationStartTime_ = wns::simulator::getEventScheduler()->getTime();
+    offsetShift_.assign(schedule_.size(), 0.0);
+    durationShift_.assign(schedule_.size(), 0.0);
+    active_ = 0;
     processOneActivation();
 }
 
@@ -262,14 +335,15 @@ TimingControl::onTimeout()
 {
     LOG_INFO(getFrameBuilder()->getFUN()->getName()," TimingControl received timeout");
 
-    if (activeCC_->compoundCollector){
+    const CompiledActivation& activation = schedule_[active_];
+    if (activation.compoundCollector){
         // pause activations do not have a compound collector
-        activeCC_->compoundCollector->stop();
+        activation.compoundCollector->stop();
     }
 
-    ++activeCC_;
+    ++active_;
 
-    if ( activeCC_ != activations_.end() ){
+    if ( active_ < schedule_.size() ){
         LOG_TRACE( getFrameBuilder()->getFUN()->getName(), ": Next Activation" );
         processOneActivation();
 
@@ -282,52 +356,159 @@ TimingControl::onTimeout()
 void
 TimingControl::processOneActivation()
 {
-    assure( activeCC_ != activations_.end(), "cannot process empty activation" );
+    assure( active_ < schedule_.size(), "cannot process empty activation" );
 
-    while ( activeCC_->action == TimingControl::StartCollection ||
-            activeCC_->action == TimingControl::FinishCollection ) {
+    // run all activations up to and including the next timed one
+    for ( ; active_ < schedule_.size(); ++active_ ) {
+        const CompiledActivation& activation = schedule_[active_];
 
-        switch ( activeCC_->action ) {
-        case TimingControl::StartCollection:
-            activeCC_->compoundCollector->setMaximumDuration( activeCC_->duration );
-            activeCC_->compoundCollector->startCollection( activeCC_->mode );
-            break;
-        case TimingControl::FinishCollection:
-            activeCC_->compoundCollector->finishCollection();
-            break;
-        default:
-            throw wns::Exception("Unknown activation in Timing Control");
+        (this->*activation.handler)(activation);
+
+        if ( activation.timed ) {
+            // set timeout to end of this phase
+            this->setTimeoutAt( getEnd(activation) );
+            return;
         }
-        ++activeCC_;
     }
+}
 
-    if ( activeCC_ == activations_.end() )
-        return;
+wns::simulator::Time
+TimingControl::getEnd(const CompiledActivation& activation) const
+{
+    std::size_t index = &activation - &schedule_[0];
+
+    return activationStartTime_
+        + activation.offset + offsetShift_[index]
+        + activation.duration + durationShift_[index];
+}
+
+std::size_t
+TimingControl::findStart(const wns::ldk::fcf::CompoundCollectorInterface* collector,
+                         std::size_t from) const
+{
+    for (std::size_t index = from; index < schedule_.size(); ++index)
+    {
+        if (schedule_[index].compoundCollector == collector
+            && schedule_[index].action == TimingControl::Start)
+            return index;
+    }
+    return schedule_.size();
+}
+
+wns::simulator::Time
+TimingControl::getPhaseDuration(const wns::ldk::fcf::CompoundCollectorInterface* collector) const
+{
+    std::size_t index = findStart(collector, 0);
+
+    if (index == schedule_.size())
+        throw wns::Exception("No phase of the compound collector in the activation schedule");
+
+    return schedule_[index].duration + durationShift_[index];
+}
+
+void
+TimingControl::movePhaseBoundary(const wns::ldk::fcf::CompoundCollectorInterface* first,
+                                 const wns::ldk::fcf::CompoundCollectorInterface* second,
+                                 wns::simulator::Time delta)
+{
+    std::size_t firstIndex = findStart(first, 0);
+    std::size_t secondIndex = findStart(second, firstIndex);
+
+    if (firstIndex == schedule_.size() || secondIndex == schedule_.size())
+        throw wns::Exception("Cannot move phase boundary, phases not found in activation schedule");
+
+    assure(active_ >= schedule_.size() || active_ < firstIndex,
+           "Cannot move the boundary of a phase that has already started");
+    assure(delta < schedule_[secondIndex].duration && -delta < schedule_[firstIndex].duration,
+           "Phase boundary moved beyond a phase");
+
+    LOG_INFO( getFrameBuilder()->getFUN()->getName(), ": moving phase boundary by ", delta, "s");
 
-    switch ( activeCC_->action ) {
+    durationShift_[firstIndex] = delta;
+    for (std::size_t index = firstIndex + 1; index <= secondIndex; ++index)
+        offsetShift_[index] = delta;
+    durationShift_[secondIndex] = -delta;
+}
+
+bool
+TimingControl::isIdle() const
+{
+    wimac::Component* component =
+        dynamic_cast<wimac::Component*>(getFrameBuilder()->getFUN()->getLayer());
+    assure(component, "TimingControl needs a wimac::Component");
 
-    case TimingControl::Start:
-        activeCC_->compoundCollector->setMaximumDuration( activeCC_->duration );
-        activeCC_->compoundCollector->start( activeCC_->mode );
+    if ( component->getTotalQueuedPDUs() > 0 )
+        return false;
 
-        //set timeout to end of this phase
-        this->setTimeout( (*activeCC_).duration );
+    // aggregated ACKs are only sent when the next frame starts
+    wns::ldk::fun::FUN* fun = getFrameBuilder()->getFUN();
+    if ( fun->knowsFunctionalUnit("ackSwitch")
+         && fun->findFriend<wimac::ACKSwitch*>("ackSwitch")->hasPendingACKs() )
+        return false;
+
+    for ( CompiledSchedule::const_iterator it = schedule_.begin(); it != schedule_.end(); ++it )
+    {
+        if ( it->action != TimingControl::Start )
+            continue;
 
-        LOG_INFO( getFrameBuilder()->getFUN()->getName(),  ": next phase activated with a duration of ",
-                  (*activeCC_).duration );
-        break;
+        DataCollector* dataCollector = dynamic_cast<DataCollector*>(it->compoundCollector);
+        if ( dataCollector == NULL )
+            continue;
 
-    case TimingControl::Pause:
-        //set timeout to end of this phase
-        this->setTimeout( (*activeCC_).duration );
+        wimac::scheduler::Scheduler* txScheduler =
+            dynamic_cast<wimac::scheduler::Scheduler*>(dataCollector->getTxScheduler());
+        wimac::scheduler::Scheduler* rxScheduler =
+            dynamic_cast<wimac::scheduler::Scheduler*>(dataCollector->getRxScheduler());
 
-        LOG_INFO( getFrameBuilder()->getFUN()->getName(),  ": pause for a duration of ",
-                  (*activeCC_).duration );
-        break;
-    default:
-        throw wns::Exception("Illegal activation entry in " +
-                             getFrameBuilder()->getFUN()->getName());
+        if ( (txScheduler && txScheduler->hasPendingWork())
+             || (rxScheduler && rxScheduler->hasPendingWork()) )
+            return false;
     }
+    return true;
+}
+
+unsigned int
+TimingControl::getCellID() const
+{
+    wimac::Component* component =
+        dynamic_cast<wimac::Component*>(getFrameBuilder()->getFUN()->getLayer());
+    assure(component, "TimingControl needs a wimac::Component");
+
+    return component->getCellID();
+}
+
+void
+TimingControl::doStart(const CompiledActivation& activation)
+{
+    // longer than configured if an elastic phase before has finished early
+    wns::simulator::Time duration =
+        getEnd(activation) - wns::simulator::getEventScheduler()->getTime();
+
+    activation.compoundCollector->setMaximumDuration( duration );
+    activation.compoundCollector->start( activation.mode );
+
+    LOG_INFO( getFrameBuilder()->getFUN()->getName(),  ": next phase activated with a duration of ",
+              duration );
+}
+
+void
+TimingControl::doStartCollection(const CompiledActivation& activation)
+{
+    activation.compoundCollector->setMaximumDuration( activation.duration );
+    activation.compoundCollector->startCollection( activation.mode );
+}
+
+void
+TimingControl::doFinishCollection(const CompiledActivation& activation)
+{
+    activation.compoundCollector->finishCollection();
+}
+
+void
+TimingControl::doPause(const CompiledActivation& activation)
+{
+    LOG_INFO( getFrameBuilder()->getFUN()->getName(),  ": pause for a duration of ",
+              activation.duration );
 }
 
 int
@@ -338,3 +519,15 @@ TimingControl::getOffset()
     int symOffset = int(offset / parameter::ThePHY::getInstance()->getSymbolDuration());
     return symOffset;
 }
+
+void
+TimingControl::setTimeoutAt(wns::simulator::Time at)
+{
+    TheFrameClock::getInstance()->wakeupAt(this, at);
+}
+
+bool
+TimingControl::hasTimeoutSet() const
+{
+    return TheFrameClock::getInstance()->hasWakeup(this);
+}
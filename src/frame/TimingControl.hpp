@@ -28,7 +28,9 @@
 
 #include <WNS/ldk/ldk.hpp>
 #include <WNS/ldk/fcf/TimingControl.hpp>
-#include <WNS/events/CanTimeout.hpp>
+#include <WNS/simulator/Time.hpp>
+
+#include <vector>
 
 
 namespace wns {
@@ -55,11 +57,14 @@ namespace wimac {
          * by three different types of Activations (Start, StartCollection,	FinishCollection).
          * The Activations specify the concrete action the CompoundCollector has to perform.
          * The chronologically ordered list of Activations is created from (/defined by) the PyConig file.
+         *
+         * Frame starts and phase timeouts are driven by the FrameClock that
+         * is shared by all stations. Phase ends are fixed offsets from the
+         * start of the activations; with elasticPhases a phase that
+         * finishes early hands its remaining time to the next phase.
          */
         class TimingControl :
-            public virtual wns::ldk::fcf::TimingControlInterface,
-            public wns::events::PeriodicTimeout,
-            public wns::events::CanTimeout
+            public virtual wns::ldk::fcf::TimingControlInterface
         {
         public:
 
@@ -72,6 +77,11 @@ namespace wimac {
 
             TimingControl( wns::ldk::fcf::FrameBuilder* fb, const wns::pyconfig::View& config );
 
+            /**
+             * @brief Leaves the FrameClock, which outlives the stations.
+             */
+            virtual ~TimingControl();
+
             void configure();
             void start();
             void pause();
@@ -83,44 +93,179 @@ namespace wimac {
                 return frameBuilder_;
             }
 
+            /**
+             * @brief Called by the FrameClock at each frame start.
+             */
             void periodically();
 
+            /**
+             * @brief Called by the FrameClock at the end of a phase.
+             */
             void onTimeout();
 
             void onFUNCreated();
 
             int getOffset();
 
-        private:
-            struct ActivationEntry
+            struct CompiledActivation;
+
+            typedef void (TimingControl::*ActionHandler)(const CompiledActivation&);
+
+            /**
+             * @brief One step of the precompiled activation schedule.
+             */
+            struct CompiledActivation
             {
                 wns::ldk::fcf::CompoundCollectorInterface* compoundCollector;
                 int mode;
                 int action;
-                double duration;
+                ActionHandler handler;
+                /** @brief Offset from the start of the activations */
+                wns::simulator::Time offset;
+                wns::simulator::Time duration;
+                /** @brief Only Start and Pause consume time */
+                bool timed;
             };
-            typedef std::list<ActivationEntry> Activations;
+            typedef std::vector<CompiledActivation> CompiledSchedule;
+
+            /**
+             * @brief The activations in the order they are processed each
+             * frame.
+             */
+            const CompiledSchedule&
+            getSchedule() const
+            {
+                return schedule_;
+            }
+
+            /**
+             * @brief Time from the start of the activations to the end of
+             * the last timed activation.
+             */
+            wns::simulator::Time
+            getScheduleDuration() const;
+
+            /**
+             * @brief Duration of the phase of collector in the current
+             * frame, including a moved phase boundary.
+             */
+            wns::simulator::Time
+            getPhaseDuration(const wns::ldk::fcf::CompoundCollectorInterface* collector) const;
+
+            /**
+             * @brief Move the boundary between the phases of first and
+             * second by delta for the current frame.
+             *
+             * The phase of first is extended by delta, the phase of second
+             * is shortened by delta and all activations in between are
+             * shifted. Activations after second are not affected. Must be
+             * called before the phase of first starts.
+             */
+            void
+            movePhaseBoundary(const wns::ldk::fcf::CompoundCollectorInterface* first,
+                              const wns::ldk::fcf::CompoundCollectorInterface* second,
+                              wns::simulator::Time delta);
+
+            /**
+             * @brief True if this station may skip idle frames.
+             */
+            bool
+            skipsIdleFrames() const
+            {
+                return skipIdleFrames_;
+            }
+
+            /**
+             * @brief True if phases finishing early hand their time to the
+             * next phase.
+             */
+            bool
+            hasElasticPhases() const
+            {
+                return elasticPhases_;
+            }
+
+            /**
+             * @brief True if neither the buffers nor the schedulers of this
+             * station hold data, no HARQ retransmission is pending and the
+             * ACKSwitch holds no ACKs for aggregation.
+             */
+            bool
+            isIdle() const;
+
+            /**
+             * @brief A sleeping station skips whole frames, starting with
+             * the next one.
+             */
+            void
+            setSleeping(bool sleeping)
+            {
+                sleeping_ = sleeping;
+            }
+
+            bool
+            isSleeping() const
+            {
+                return sleeping_;
+            }
 
+            /**
+             * @brief The cell this station belongs to, 0 if not associated.
+             */
+            unsigned int
+            getCellID() const;
+
+        private:
             void startProcessingActivations();
             void processOneActivation();
 
             /**
-             * @brief Chronologically ordered list of activations.
+             * @brief Index of the first Start activation of collector at
+             * or after index from, schedule_.size() if there is none.
+             */
+            std::size_t
+            findStart(const wns::ldk::fcf::CompoundCollectorInterface* collector,
+                      std::size_t from) const;
+
+            void compileSchedule();
+            void validateSchedule() const;
+
+            /**
+             * @brief Absolute end of activation in the current frame.
+             */
+            wns::simulator::Time getEnd(const CompiledActivation& activation) const;
+
+            void doStart(const CompiledActivation& activation);
+            void doStartCollection(const CompiledActivation& activation);
+            void doFinishCollection(const CompiledActivation& activation);
+            void doPause(const CompiledActivation& activation);
+
+            void setTimeoutAt(wns::simulator::Time at);
+            bool hasTimeoutSet() const;
+
+            /**
+             * @brief Chronologically ordered activations compiled from the
+             * configuration.
              *
              * For the modes sending and receiving a CompoundCollector
              * has three Activations: startCollection,
              * finishCollection, start For the mode pause only one
              * activation is valid: pause
              */
-            Activations activations_;
+            CompiledSchedule schedule_;
 
             /**
-             * @brief Indicates the active CompoundCollector.
+             * @brief Index of the active activation, schedule_.size() if
+             * the frame is finished.
              */
-            Activations::const_iterator activeCC_;
+            std::size_t active_;
 
-            // iterator is used for validation only ( assure(timeoutIsForMe == activeCC_, ...) )
-            //Activations::const_iterator timeoutIsForMe;
+            /**
+             * @brief Per activation changes of offset and duration in the
+             * current frame, reset at each frame start.
+             */
+            std::vector<wns::simulator::Time> offsetShift_;
+            std::vector<wns::simulator::Time> durationShift_;
 
             wns::ldk::fcf::FrameBuilder* frameBuilder_;
 
@@ -128,9 +273,24 @@ namespace wimac {
             wns::pyconfig::View config_;
 
             wns::simulator::Time frameStartupDelay_;
+
+            /**
+             * @brief If a compound collector reports to have finished its
+             * phase early, the next phase starts immediately.
+             */
+            bool elasticPhases_;
+
+            /**
+             * @brief If the FrameClock finds the whole cell idle, the
+             * activations of the frame are not processed.
+             */
+            bool skipIdleFrames_;
+
+            bool sleeping_;
             wns::simulator::Time frameStartTime_;
+            wns::simulator::Time activationStartTime_;
 
-            friend class TriggerActivationStart;
+            friend class FrameClock;
         };
     }
 }
@@ -25,6 +25,8 @@
 
 #include <WIMAC/frame/ULMapCollector.hpp>
 
+#include <sstream>
+
 #include <WNS/ldk/Compound.hpp>
 #include <WNS/ldk/fcf/TimingControl.hpp>
 
@@ -64,10 +66,13 @@ ULMapCollector::ULMapCollector( wns::ldk::fun::FUN* fun, const wns::pyconfig::Vi
     phyUser_(0),
     phyMode(wns::SmartPtr<const wns::service::phy::phymode::PhyModeInterface>
             (wns::service::phy::phymode::createPhyMode( config.getView("phyMode") ) ) ),
+    mapSizing_(config.getView("mapSizing"), phyMode),
     //hasUplinkBurst_(false),
     //myBursts_(new wns::scheduler::MapInfoCollection)
     ulResourcesAvailable_(false),
     scheduledULMap_(wns::scheduler::SchedulingMapPtr()),
+    grantIndex_(),
+    myGrants_(NULL),
     estimatedCQI_(wns::scheduler::ChannelQualityOnOneSubChannel())
 
 {
@@ -108,19 +113,23 @@ void ULMapCollector::doStart(int mode)
     switch (mode) {
     case Sending:
     {
-        wns::ldk::CompoundPtr compound
-            ( new wns::ldk::Compound( getFUN()->getProxy()->createCommandPool() ) );
-        ULMapCommand* command = activateCommand( compound->getCommandPool() );
+        if ( template_ == wns::ldk::CompoundPtr() )
+            createTemplate();
+
+        wns::ldk::CompoundPtr compound = template_->copy();
+        ULMapCommand* command = getCommand( compound->getCommandPool() );
         command->peer.phaseDuration =
             ulScheduler_->getDuration();
-        command->peer.baseStationID =
-            component_->getID();
         command->local.numBursts =
             ulScheduler_->getNumBursts();
+        command->local.mapSize =
+            mapSizing_.getSize(ulScheduler_->getBursts());
         //command->peer.mapInfo =
           //  ulScheduler_->getMapInfo();
         command->peer.schedulingMap =
             ulScheduler_->getSchedulingMap();
+        command->peer.grantIndex =
+            ulScheduler_->getGrantIndex();
         // map duration is a little shorter than the phase duration
         command->local.mapDuration =
             getCurrentDuration() - Utilities::getComputationalAccuracyFactor();
@@ -128,22 +137,13 @@ void ULMapCollector::doStart(int mode)
         assure( command->local.mapDuration <= this->getMaximumDuration(),
                 "ULMapCollector: PDU overun the maximum duration of the frame phase!");
 
-        PhyUserCommand* phyCommand = dynamic_cast<wimac::PhyUserCommand*>
-            ( getFUN()->getProxy()->activateCommand( compound->getCommandPool(), phyUser_) );
-        phyCommand->peer.destination_ = 0;
+        PhyUserCommand* phyCommand = phyUser_->getCommand( compound->getCommandPool() );
         phyCommand->peer.cellID_ = component_->getCellID();
-        phyCommand->peer.source_ = component_->getNode();
-        assureNotNull(phyMode.getPtr());
-        phyCommand->peer.phyModePtr = phyMode;
-        phyCommand->magic.sourceComponent_ = component_;
 
         wns::simulator::Time now = wns::simulator::getEventScheduler()->getTime();
-        phyCommand->local.pAFunc_.reset
-            ( new BroadcastPhyAccessFunc );
         phyCommand->local.pAFunc_->transmissionStart_ = now;
         phyCommand->local.pAFunc_->transmissionStop_ = now + getCurrentDuration()
              - Utilities::getComputationalAccuracyFactor();
-        phyCommand->local.pAFunc_->phyMode_ = phyMode;
 
         setTimeout( getCurrentDuration() - Utilities::getComputationalAccuracyFactor() );
         LOG_INFO( getFUN()->getLayer()->getName(), " send UL Map of size: ", command->local.numBursts );
@@ -159,6 +159,29 @@ void ULMapCollector::doStart(int mode)
     }
 }
 
+void
+ULMapCollector::createTemplate()
+{
+    template_ = wns::ldk::CompoundPtr(
+        new wns::ldk::Compound( getFUN()->getProxy()->createCommandPool() ) );
+
+    ULMapCommand* command = activateCommand( template_->getCommandPool() );
+    command->peer.baseStationID =
+        component_->getID();
+
+    PhyUserCommand* phyCommand = dynamic_cast<wimac::PhyUserCommand*>
+        ( getFUN()->getProxy()->activateCommand( template_->getCommandPool(), phyUser_) );
+    phyCommand->peer.destination_ = 0;
+    phyCommand->peer.source_ = component_->getNode();
+    assureNotNull(phyMode.getPtr());
+    phyCommand->peer.phyModePtr = phyMode;
+    phyCommand->magic.sourceComponent_ = component_;
+
+    phyCommand->local.pAFunc_.reset
+        ( new BroadcastPhyAccessFunc );
+    phyCommand->local.pAFunc_->phyMode_ = phyMode;
+}
+
 void
 ULMapCollector::onTimeout()
 {
@@ -169,26 +192,30 @@ void
 ULMapCollector::calculateSizes( const wns::ldk::CommandPool* commandPool, Bit& commandPoolSize, Bit& dataSize ) const
 {
     //What are the sizes in the upper Layers
-    /** @todo: update to 16e or 16m MAP size */
     getFUN()->getProxy()->calculateSizes(commandPool, commandPoolSize, dataSize, this);
 
     ULMapCommand* command = getCommand( commandPool );
-    commandPoolSize += ( 56 + command->local.numBursts * 48 );
+    commandPoolSize += command->local.mapSize;
 }
 
-wns::simulator::Time ULMapCollector::getCurrentDuration() const
+wns::simulator::Time ULMapCollector::getMapDuration() const
 {
-    double dataRate =
-        phyMode->getDataRate();
+    return mapSizing_.getDuration(ulScheduler_->getBursts());
+}
 
-    Bit compoundSize =
-        56 + ulScheduler_->getNumBursts(); /** 48;*/
-    wns::simulator::Time symbolDuration = parameter::ThePHY::getInstance()->getSymbolDuration();
-    wns::simulator::Time roundedDuration =
-        ceil( (compoundSize / dataRate ) / symbolDuration ) * symbolDuration;
+wns::simulator::Time ULMapCollector::getCurrentDuration() const
+{
+    wns::simulator::Time duration = getMapDuration();
 
-    //fixme(bmw) (fixed map overhead of one symbol due to wrong calculation of map duration with subchannels)
-    return symbolDuration; //roundedDuration;
+    if (duration > getMaximumDuration())
+    {
+        std::stringstream ss;
+        ss << getFUN()->getLayer()->getName() << ": UL-MAP of " << duration
+           << "s does not fit into its phase of " << getMaximumDuration()
+           << "s, use a longer MAP phase or a compressed MAP format";
+        throw wns::Exception( ss.str() );
+    }
+    return duration;
 }
 
 void ULMapCollector::doOnData( const wns::ldk::CompoundPtr& compound )
@@ -211,12 +238,24 @@ void ULMapCollector::doOnData( const wns::ldk::CompoundPtr& compound )
 
 	// check if at least one of the frames contains granted ul resources
 	ulResourcesAvailable_ = false;
-        LOG_INFO("ULMAP saving now: ");
+	myGrants_ = NULL;
         scheduledULMap_ = command->peer.schedulingMap;
-	LOG_INFO("ULMAP = ", scheduledULMap_->toString());
-        //Clear old MAPlist
-	//scheduledULMap_->clear();
-	if (scheduledULMap_->hasResourcesForUser(me_))
+        grantIndex_ = command->peer.grantIndex;
+
+	if (grantIndex_ != wimac::scheduler::GrantIndexPtr())
+	{
+		// only look at the own grants instead of the whole map
+		myGrants_ = grantIndex_->find(me_);
+		if (myGrants_ != NULL)
+		{
+			ulResourcesAvailable_ = true;
+			LOG_INFO( getFUN()->getLayer()->getName(), " has ",
+				  myGrants_->grants.size(), " granted resource ranges" );
+			estimatedCQI_ = myGrants_->estimatedCQI;
+		}
+	}
+	else if (scheduledULMap_ != wns::scheduler::SchedulingMapPtr()
+		 && scheduledULMap_->hasResourcesForUser(me_))
 	{
 		ulResourcesAvailable_ = true; // assume always true when a MAP comes
                 LOG_INFO( getFUN()->getLayer()->getName(), " has granted resources" );
@@ -33,6 +33,7 @@
 #include <WNS/scheduler/MapInfoProviderInterface.hpp>
 #include <WNS/ldk/tools/UpUnconnectable.hpp>
 #include <WIMAC/frame/MapCommand.hpp>
+#include <WIMAC/frame/MapSizing.hpp>
 
 
 namespace wimac {
@@ -101,6 +102,11 @@ namespace wimac { namespace frame {
 
             wns::simulator::Time getCurrentDuration() const;
 
+            /**
+             * @brief Air time of the UL-MAP for the current UL schedule.
+             */
+            wns::simulator::Time getMapDuration() const;
+
 /* old interface - to be removed*/
             wns::simulator::Time getULPhaseDuration() const { return ulPhaseDuration_; }
 
@@ -145,8 +151,22 @@ namespace wimac { namespace frame {
              virtual wns::scheduler::SchedulingMapPtr getMasterMapForSlaveScheduling() { 
                 return scheduledULMap_;
              }
+
+            /**
+             * @brief Own grants of the last received UL-MAP, NULL if there
+             * are none.
+             */
+            const wimac::scheduler::GrantIndex::UserGrants*
+            getGrants() const {
+                return myGrants_;
+            }
             
         private:
+            /**
+             * @brief Build the compound that is copied for each MAP.
+             */
+            void createTemplate();
+
             wimac::scheduler::Scheduler* ulScheduler_;
             std::string ulSchedulerName_;
             wimac::Component* component_;
@@ -159,6 +179,14 @@ namespace wimac { namespace frame {
              * @brief PhyMode to be used for the MAP.
              */
             wns::SmartPtr<const wns::service::phy::phymode::PhyModeInterface> phyMode;
+
+            MapSizing mapSizing_;
+
+            /**
+             * @brief MAP with all fields set that do not change from frame
+             * to frame.
+             */
+            wns::ldk::CompoundPtr template_;
 /*old MapCollector variables*/
             wns::simulator::Time ulPhaseDuration_;
             wns::simulator::Time burstStartTime_;
@@ -169,6 +197,9 @@ namespace wimac { namespace frame {
             bool hasUplinkBurst_;
 /*new Mapcollector variables*/
             wns::scheduler::SchedulingMapPtr scheduledULMap_;
+            // keeps myGrants_ valid
+            wimac::scheduler::GrantIndexPtr grantIndex_;
+            const wimac::scheduler::GrantIndex::UserGrants* myGrants_;
 
             /**
              * @brief PhyMode to be used for the burst.
@@ -32,9 +32,12 @@
 
 #include <WNS/ldk/Layer.hpp>
 #include <WNS/ldk/Classifier.hpp>
+#include <WNS/ldk/crc/CRC.hpp>
 
 #include <WIMAC/ACKSwitch.hpp>
 #include <WIMAC/Classifier.hpp>
+#include <WIMAC/ErrorModelling.hpp>
+#include <WIMAC/PhyUser.hpp>
 #include <WIMAC/services/ConnectionManager.hpp>
 
 STATIC_FACTORY_REGISTER_WITH_CREATOR(
@@ -75,8 +78,12 @@ BSRelayMapper::BSRelayMapper( wns::ldk::fun::FUN* fun, const wns::pyconfig::View
 {}
 
 RSRelayMapper::RSRelayMapper( wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config )
-    : RelayMapper( fun, config )
+    : RelayMapper( fun, config ),
+      connectionManager_( NULL ),
+      forwardInPlace_( config.get<bool>("forwardInPlace") )
 {
+    for ( int i = 0; i < config.len("resetFUs"); ++i )
+        resetFUNames_.push_back( config.get<std::string>("resetFUs", i) );
 }
 
 void RSRelayMapper::onFUNCreated()
@@ -96,6 +103,43 @@ void RSRelayMapper::onFUNCreated()
             getFUN()->findFriend<wimac::ACKSwitch*>("ackSwitch");
         assure( ackSwitch_, "ackSwitch not found in FUN");
     }
+
+    resetFUs_.clear();
+    bool resetsPhyUser = false;
+    bool resetsErrorModelling = false;
+    bool resetsCRC = false;
+    for ( std::vector<std::string>::const_iterator it = resetFUNames_.begin();
+          it != resetFUNames_.end();
+          ++it )
+    {
+        wns::ldk::FunctionalUnit* fu = getFUN()->getFunctionalUnit( *it );
+        resetsPhyUser |= dynamic_cast<wimac::PhyUser*>( fu ) != NULL;
+        resetsErrorModelling |= dynamic_cast<wimac::ErrorModelling*>( fu ) != NULL;
+        resetsCRC |= dynamic_cast<wns::ldk::crc::CRC*>( fu ) != NULL;
+        resetFUs_.push_back( fu );
+    }
+
+    // Stale lower commands would make the next hop skip its own
+    // reception, e.g. the evaluated/decided flags of ErrorModelling
+    if ( forwardInPlace_ )
+        assure( resetsPhyUser && resetsErrorModelling && resetsCRC,
+                "forwardInPlace needs resetFUs to include the PhyUser, ErrorModelling and CRC FUs" );
+
+    connectionManager_ = getFUN()->getLayer()
+        ->getManagementService<service::ConnectionManager>("connectionManager");
+    assure( connectionManager_, "connectionManager not found in layer" );
+
+    wns::Observer<service::ConnectionDeletedNotification>
+        ::startObserving( connectionManager_ );
+}
+
+void RSRelayMapper::notifyAboutConnectionDeleted( const wimac::ConnectionIdentifier ci )
+{
+    // a changed connection keeps its CID and thus its mapping
+    if ( connectionManager_->isChanging() )
+        return;
+
+    removeMapping( ci.cid_ );
 }
 
 void RSRelayMapper::processOutgoing( const wns::ldk::CompoundPtr&
@@ -121,27 +165,20 @@ void RSRelayMapper::processIncoming( const wns::ldk::CompoundPtr& compound )
         ss << "no mapping registered for CID " << clcom->peer.id;
         assure( 0, ss.str() );
     }
+
+    if ( forwardInPlace_ )
+    {
+        forwardInPlace( compound, mapping );
+        return;
+    }
+
     wns::ldk::CommandPool* injection =
         getFUN()->getProxy()->createCommandPool();
 
     getFUN()->getProxy()
         ->partialCopy( this, injection, compound->getCommandPool() );
 
-    if ( ackSwitch_
-         && getFUN()->getProxy()->commandIsActivated( compound->getCommandPool(), ackSwitch_ ) )
-    {
-        // we need to switch the CID of the ACK too
-        wimac::AckSwitchCommand* ackCom =
-            ackSwitch_->getCommand( compound->getCommandPool() );
-        wimac::AckSwitchCommand* injectACKCom =
-            ackSwitch_->getCommand( injection );
-        RelayMapping ackMapping =
-            findMapping( ackCom->peer.originalCID );
-        if ( ackCom->peer.originalCID == ackMapping.upperConnection_ )
-            injectACKCom->peer.originalCID = ackMapping.lowerConnection_;
-        else
-            injectACKCom->peer.originalCID = ackMapping.upperConnection_;
-    }
+    mapACK( compound->getCommandPool(), injection );
 
     wns::ldk::ClassifierCommand* injectClcom =
         classifier_->getCommand( injection );
@@ -176,22 +213,113 @@ void RSRelayMapper::processIncoming( const wns::ldk::CompoundPtr& compound )
     }
 }
 
-RSRelayMapper::RelayMapping
-RSRelayMapper::findMapping( const wimac::ConnectionIdentifier::CID& id ) const
+void RSRelayMapper::forwardInPlace( const wns::ldk::CompoundPtr& compound,
+                                    const RelayMapping& mapping )
 {
-    for ( Mappings::const_iterator it = mappings_.begin();
-          it != mappings_.end();
+    wns::ldk::CommandPool* commandPool = compound->getCommandPool();
+    wns::ldk::CommandProxy* proxy = getFUN()->getProxy();
+
+    mapACK( commandPool, commandPool );
+
+    // The commands of the FUs below have been filled in on the
+    // previous hop and are activated again on the way down.
+    for ( std::vector<wns::ldk::FunctionalUnit*>::const_iterator it = resetFUs_.begin();
+          it != resetFUs_.end();
           ++it )
     {
-        if ( id == it->upperConnection_ || id == it->lowerConnection_ )
-            return *it;
+        if ( proxy->commandIsActivated( commandPool, *it ) )
+            proxy->removeCommand( commandPool, *it );
+    }
+
+    RelayMapperCommand* rCommand =
+        proxy->commandIsActivated( commandPool, this )
+        ? getCommand( commandPool )
+        : activateCommand( commandPool );
+
+    wns::ldk::ClassifierCommand* clcom =
+        classifier_->getCommand( commandPool );
+
+    if ( clcom->peer.id == mapping.upperConnection_ )
+    {
+        LOG_INFO(getFUN()->getLayer()->getName(),
+                 " rewrites compound CID from ", clcom->peer.id, " down to ",
+                 mapping.lowerConnection_ );
+        clcom->peer.id = mapping.lowerConnection_;
+        rCommand->peer.direction_ = RelayMapperCommand::Down;
+
+        downRelayInject_->sendData( compound );
+    }
+    else
+    {
+        LOG_INFO(getFUN()->getLayer()->getName(),
+                 " rewrites compound CID from ", clcom->peer.id, " up to ",
+                 mapping.upperConnection_ );
+        clcom->peer.id = mapping.upperConnection_;
+        rCommand->peer.direction_ = RelayMapperCommand::Up;
+
+        upRelayInject_->sendData( compound );
     }
-    return RelayMapping();
+}
+
+void RSRelayMapper::mapACK( wns::ldk::CommandPool* received,
+                            wns::ldk::CommandPool* forwarded )
+{
+    if ( !ackSwitch_
+         || !getFUN()->getProxy()->commandIsActivated( received, ackSwitch_ ) )
+        return;
+
+    // we need to switch the CID of the ACK too
+    wimac::AckSwitchCommand* ackCom =
+        ackSwitch_->getCommand( received );
+    wimac::AckSwitchCommand* forwardedACKCom =
+        ackSwitch_->getCommand( forwarded );
+    forwardedACKCom->peer.originalCID =
+        getPartner( ackCom->peer.originalCID );
+
+    // and the CIDs of all ACKs merged into this one
+    for ( size_t i = 0; i < ackCom->peer.acks.size(); ++i )
+        forwardedACKCom->peer.acks[i].originalCID =
+            getPartner( ackCom->peer.acks[i].originalCID );
+}
+
+wimac::ConnectionIdentifier::CID
+RSRelayMapper::getPartner( const wimac::ConnectionIdentifier::CID& id ) const
+{
+    RelayMapping mapping = findMapping( id );
+    if ( id == mapping.upperConnection_ )
+        return mapping.lowerConnection_;
+    return mapping.upperConnection_;
+}
+
+RSRelayMapper::RelayMapping
+RSRelayMapper::findMapping( const wimac::ConnectionIdentifier::CID& id ) const
+{
+    Mappings::const_iterator it = mappings_.find( id );
+    if ( it == mappings_.end() )
+        return RelayMapping();
+    return it->second;
 }
 
 void RSRelayMapper::addMapping( const wimac::relay::RSRelayMapper::RelayMapping& mapping )
 {
-    mappings_.push_back( mapping );
+    // A CID may only belong to one mapping. Replacing a stale mapping
+    // must not leave its partner CID behind.
+    removeMapping( mapping.upperConnection_ );
+    removeMapping( mapping.lowerConnection_ );
+
+    mappings_[mapping.upperConnection_] = mapping;
+    mappings_[mapping.lowerConnection_] = mapping;
+}
+
+void RSRelayMapper::removeMapping( const wimac::ConnectionIdentifier::CID& id )
+{
+    Mappings::iterator it = mappings_.find( id );
+    if ( it == mappings_.end() )
+        return;
+
+    RelayMapping mapping = it->second;
+    mappings_.erase( mapping.upperConnection_ );
+    mappings_.erase( mapping.lowerConnection_ );
 }
 
 bool RSRelayMapper::RelayMapping::operator==(const RelayMapping& rhs ) const
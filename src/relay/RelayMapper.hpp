@@ -39,13 +39,14 @@
 #include <WNS/ldk/FunctionalUnit.hpp>
 #include <WNS/ldk/Command.hpp>
 #include <WNS/ldk/CommandTypeSpecifier.hpp>
+#include <WNS/Observer.hpp>
 #include <WIMAC/ConnectionIdentifier.hpp>
+#include <WIMAC/services/ConnectionManager.hpp>
 
-namespace wimac {
+#include <tr1/unordered_map>
+#include <vector>
 
-    namespace service {
-        class ConnectionManager;
-    }
+namespace wimac {
 
     class ConnectionClassifier;
     class ACKSwitch;
@@ -115,6 +116,11 @@ namespace wimac {
 
         /**
          * @brief Implemenattion of the RelayMapper in the RS.
+         *
+         * Mappings are indexed by both their upper and their lower
+         * CID, so a lookup costs the same regardless of how many UTs
+         * the RS serves. A mapping is removed as soon as one of its
+         * connections is deleted in the ConnectionManager of the RS.
          */
         class RSRelayMapper :
             public RelayMapper,
@@ -122,7 +128,8 @@ namespace wimac {
             public wns::ldk::HasReceptor<>,
             public wns::ldk::HasDeliverer<>,
             public wns::ldk::Processor<RSRelayMapper>,
-            public wns::Cloneable<RSRelayMapper>
+            public wns::Cloneable<RSRelayMapper>,
+            public wns::Observer<service::ConnectionDeletedNotification>
         {
         public:
             RSRelayMapper( wns::ldk::fun::FUN* fun, const wns::pyconfig::View& config );
@@ -139,6 +146,11 @@ namespace wimac {
              */
             void processOutgoing( const wns::ldk::CompoundPtr& );
 
+            /**
+             * @brief Drop the mapping of a deleted connection.
+             */
+            void notifyAboutConnectionDeleted( const ConnectionIdentifier ci );
+
             /**
              * @brief One mapping that is stored in the RelayMapper.
              */
@@ -152,6 +164,16 @@ namespace wimac {
                     upperConnection_(upperConnection),
                     lowerConnection_(lowerConnection){}
 
+                ConnectionIdentifier::CID getUpperConnection() const
+                {
+                    return upperConnection_;
+                }
+
+                ConnectionIdentifier::CID getLowerConnection() const
+                {
+                    return lowerConnection_;
+                }
+
                 bool operator==( const RelayMapping& rhs ) const;
                 bool operator!=( const RelayMapping& rhs ) const
                 {
@@ -171,19 +193,65 @@ namespace wimac {
             service::ConnectionManager* connectionManager_;
             wimac::ACKSwitch* ackSwitch_;
 
+            /**
+             * @brief Rewrite the CIDs of the received compound and
+             * send it on instead of building a new compound from a
+             * partial copy of the command pool.
+             */
+            bool forwardInPlace_;
+
+            /**
+             * @brief FUs below the RelayMapper whose commands are
+             * reset before a compound is forwarded in place.
+             */
+            std::vector<std::string> resetFUNames_;
+            std::vector<wns::ldk::FunctionalUnit*> resetFUs_;
+
             /**
              * @brief The functional unit for which the upper commands shall be copied.
              */
             wns::ldk::FunctionalUnit* copyThreshold_;
             std::string copyThresholdName_;
 
+            /**
+             * @brief Rewrite the CID of the ACK carried by the
+             * compound according to its mapping.
+             */
+            void
+            mapACK( wns::ldk::CommandPool* received,
+                    wns::ldk::CommandPool* forwarded );
+
+            /**
+             * @brief The CID mapped to id in the other direction.
+             */
+            ConnectionIdentifier::CID
+            getPartner( const ConnectionIdentifier::CID& id ) const;
+
+            /**
+             * @brief Forward the received compound itself after
+             * rewriting its CIDs and resetting the lower commands.
+             */
+            void
+            forwardInPlace( const wns::ldk::CompoundPtr& compound,
+                            const RelayMapping& mapping );
+
         public:
             RelayMapping findMapping( const ConnectionIdentifier::CID& id ) const;
 
             void addMapping( const RelayMapping& mapping );
 
+            /**
+             * @brief Remove the mapping containing the given CID in
+             * either direction.
+             */
+            void removeMapping( const ConnectionIdentifier::CID& id );
+
         private:
-            typedef std::list<RelayMapping> Mappings;
+            /**
+             * @brief Every mapping is stored twice, once under its
+             * upper and once under its lower CID.
+             */
+            typedef std::tr1::unordered_map<ConnectionIdentifier::CID, RelayMapping> Mappings;
             Mappings mappings_;
         };
 
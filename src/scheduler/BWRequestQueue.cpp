@@ -0,0 +1,367 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/scheduler/BWRequestQueue.hpp>
+#include <WIMAC/Logger.hpp>
+
+#include <WNS/ldk/fun/FUN.hpp>
+#include <WNS/ldk/helper/FakePDU.hpp>
+#include <WNS/scheduler/RegistryProxyInterface.hpp>
+
+#include <WNS/ldk/CommandTypeSpecifier.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+STATIC_FACTORY_REGISTER_WITH_CREATOR(wimac::scheduler::BWRequestQueue,
+                                     wns::scheduler::queue::QueueInterface,
+                                     "wimac.BWRequestQueue",
+                                     wns::HasReceptorConfigCreator);
+
+using namespace wimac::scheduler;
+
+BWRequestQueue::BWRequestQueue(wns::ldk::HasReceptorInterface*, const wns::pyconfig::View& config) :
+    requests_(),
+    maxSize_(config.get<int>("maxSize")),
+    fun_(NULL)
+{
+    assure(maxSize_ > 0, "maxSize must be positive");
+
+    friends_.classifierName = config.get<std::string>("classifier");
+    friends_.classifier = NULL;
+    colleagues_.registry = NULL;
+}
+
+void
+BWRequestQueue::setBWRequest(wns::scheduler::ConnectionID cid,
+                             wns::scheduler::UserID user,
+                             unsigned long int pdus,
+                             Bit bits)
+{
+    if (pdus == 0 || bits <= 0)
+    {
+        requests_.erase(cid);
+        return;
+    }
+
+    if (pdus > maxSize_)
+    {
+        LOG_TRACE("BWRequestQueue: CID ", cid, " request of ", pdus, " PDUs cut to ", maxSize_);
+        bits = Bit(bits * (double(maxSize_) / pdus));
+        pdus = maxSize_;
+    }
+
+    BWRequest& request = requests_[cid];
+    request.user = user;
+    request.pdus = pdus;
+    request.bits = bits;
+
+    LOG_TRACE("BWRequestQueue: CID ", cid, " requests ", bits, " bits in ", pdus, " PDUs");
+}
+
+const BWRequestQueue::BWRequestContainer&
+BWRequestQueue::getBWRequests() const
+{
+    return requests_;
+}
+
+bool
+BWRequestQueue::queueHasPDUs(wns::scheduler::ConnectionID cid) const
+{
+    return requests_.find(cid) != requests_.end();
+}
+
+bool
+BWRequestQueue::isEmpty() const
+{
+    return requests_.empty();
+}
+
+wns::scheduler::ConnectionSet
+BWRequestQueue::filterQueuedCids(wns::scheduler::ConnectionSet connections)
+{
+    wns::scheduler::ConnectionSet result;
+    for (wns::scheduler::ConnectionSet::const_iterator it = connections.begin();
+         it != connections.end(); ++it)
+    {
+        if (queueHasPDUs(*it))
+            result.insert(*it);
+    }
+    return result;
+}
+
+wns::ldk::CompoundPtr
+BWRequestQueue::getHeadOfLinePDU(wns::scheduler::ConnectionID cid)
+{
+    BWRequestContainer::iterator it = requests_.find(cid);
+    assure(it != requests_.end(), "wimac::BWRequestQueue: no bandwidth request for this CID");
+
+    Bit bits = it->second.bits / it->second.pdus;
+
+    --(it->second.pdus);
+    it->second.bits -= bits;
+
+    if (it->second.pdus == 0)
+        requests_.erase(it);
+
+    return createPlaceholder(cid, bits);
+}
+
+int
+BWRequestQueue::getHeadOfLinePDUbits(wns::scheduler::ConnectionID cid)
+{
+    BWRequestContainer::const_iterator it = requests_.find(cid);
+    if (it == requests_.end())
+        return 0;
+
+    return it->second.bits / it->second.pdus;
+}
+
+bool
+BWRequestQueue::hasQueue(wns::scheduler::ConnectionID cid)
+{
+    return queueHasPDUs(cid);
+}
+
+wns::scheduler::queue::QueueInterface::ProbeOutput
+BWRequestQueue::erase(BWRequestContainer::iterator it)
+{
+    wns::scheduler::queue::QueueInterface::ProbeOutput probeOutput;
+    probeOutput.bits = it->second.bits;
+    probeOutput.compounds = it->second.pdus;
+    requests_.erase(it);
+    return probeOutput;
+}
+
+wns::scheduler::queue::QueueInterface::ProbeOutput
+BWRequestQueue::resetAllQueues()
+{
+    wns::scheduler::queue::QueueInterface::ProbeOutput probeOutput;
+    while (!requests_.empty())
+    {
+        wns::scheduler::queue::QueueInterface::ProbeOutput erased = erase(requests_.begin());
+        probeOutput.bits += erased.bits;
+        probeOutput.compounds += erased.compounds;
+    }
+    return probeOutput;
+}
+
+wns::scheduler::queue::QueueInterface::ProbeOutput
+BWRequestQueue::resetQueues(wns::scheduler::UserID user)
+{
+    wns::scheduler::queue::QueueInterface::ProbeOutput probeOutput;
+    BWRequestContainer::iterator it = requests_.begin();
+    while (it != requests_.end())
+    {
+        if (it->second.user == user)
+        {
+            wns::scheduler::queue::QueueInterface::ProbeOutput erased = erase(it++);
+            probeOutput.bits += erased.bits;
+            probeOutput.compounds += erased.compounds;
+        }
+        else
+            ++it;
+    }
+    return probeOutput;
+}
+
+wns::scheduler::queue::QueueInterface::ProbeOutput
+BWRequestQueue::resetQueue(wns::scheduler::ConnectionID cid)
+{
+    BWRequestContainer::iterator it = requests_.find(cid);
+    if (it == requests_.end())
+        return wns::scheduler::queue::QueueInterface::ProbeOutput();
+
+    return erase(it);
+}
+
+void
+BWRequestQueue::frameStarts()
+{
+}
+
+bool
+BWRequestQueue::supportsDynamicSegmentation() const
+{
+    return true;
+}
+
+wns::ldk::CompoundPtr
+BWRequestQueue::getHeadOfLinePDUSegment(wns::scheduler::ConnectionID cid, int bits)
+{
+    BWRequestContainer::iterator it = requests_.find(cid);
+    assure(it != requests_.end(), "wimac::BWRequestQueue: no bandwidth request for this CID");
+    assure(bits > 0, "wimac::BWRequestQueue: requested an empty segment");
+
+    BWRequest& request = it->second;
+    Bit pduSize = std::max<Bit>(1, request.bits / request.pdus);
+    Bit granted = std::min<Bit>(bits, request.bits);
+
+    // A segment accounts for the PDUs it completes, at least one
+    unsigned long int pdus = std::max<unsigned long int>(1, granted / pduSize);
+
+    request.bits -= granted;
+
+    if (request.bits <= 0)
+        requests_.erase(it);
+    else
+        request.pdus = std::max<unsigned long int>(1, request.pdus - std::min(pdus, request.pdus));
+
+    return createPlaceholder(cid, granted);
+}
+
+wns::scheduler::UserSet
+BWRequestQueue::getQueuedUsers() const
+{
+    wns::scheduler::UserSet users;
+    for (BWRequestContainer::const_iterator it = requests_.begin();
+         it != requests_.end(); ++it)
+        users.insert(it->second.user);
+
+    return users;
+}
+
+wns::scheduler::ConnectionSet
+BWRequestQueue::getActiveConnections() const
+{
+    wns::scheduler::ConnectionSet connections;
+    for (BWRequestContainer::const_iterator it = requests_.begin();
+         it != requests_.end(); ++it)
+        connections.insert(it->first);
+
+    return connections;
+}
+
+wns::scheduler::ConnectionSet
+BWRequestQueue::getActiveConnectionsForPriority(unsigned int priority) const
+{
+    assure(colleagues_.registry, "wimac::BWRequestQueue: registry not set");
+
+    wns::scheduler::ConnectionSet connections;
+    for (BWRequestContainer::const_iterator it = requests_.begin();
+         it != requests_.end(); ++it)
+    {
+        if (colleagues_.registry->getPriorityForConnection(it->first) == priority)
+            connections.insert(it->first);
+    }
+    return connections;
+}
+
+unsigned long int
+BWRequestQueue::numCompoundsForCid(wns::scheduler::ConnectionID cid) const
+{
+    BWRequestContainer::const_iterator it = requests_.find(cid);
+    if (it == requests_.end())
+        return 0;
+
+    return it->second.pdus;
+}
+
+unsigned long int
+BWRequestQueue::numBitsForCid(wns::scheduler::ConnectionID cid) const
+{
+    BWRequestContainer::const_iterator it = requests_.find(cid);
+    if (it == requests_.end())
+        return 0;
+
+    return it->second.bits;
+}
+
+wns::scheduler::QueueStatusContainer
+BWRequestQueue::getQueueStatus(bool) const
+{
+    wns::scheduler::QueueStatusContainer queueStatusContainer;
+    for (BWRequestContainer::const_iterator it = requests_.begin();
+         it != requests_.end(); ++it)
+    {
+        wns::scheduler::QueueStatus queueStatus;
+        queueStatus.numOfBits = it->second.bits;
+        queueStatus.numOfCompounds = it->second.pdus;
+        queueStatusContainer.insert(it->first, queueStatus);
+    }
+    return queueStatusContainer;
+}
+
+bool
+BWRequestQueue::isAccepting(const wns::ldk::CompoundPtr&) const
+{
+    return false;
+}
+
+void
+BWRequestQueue::put(const wns::ldk::CompoundPtr&)
+{
+    throw wns::Exception("wimac::BWRequestQueue only holds bandwidth requests, use setBWRequest()");
+}
+
+std::queue<wns::ldk::CompoundPtr>
+BWRequestQueue::getQueueCopy(wns::scheduler::ConnectionID)
+{
+    throw wns::Exception("You should not call getQueueCopy of the BWRequestQueue.");
+}
+
+void
+BWRequestQueue::setColleagues(wns::scheduler::RegistryProxyInterface* registry)
+{
+    colleagues_.registry = registry;
+}
+
+void
+BWRequestQueue::setFUN(wns::ldk::fun::FUN* fun)
+{
+    fun_ = fun;
+    friends_.classifier =
+        fun_->findFriend<wns::ldk::CommandTypeSpecifier<wns::ldk::ClassifierCommand>*>
+        (friends_.classifierName);
+}
+
+std::string
+BWRequestQueue::printAllQueues()
+{
+    std::stringstream s;
+    for (BWRequestContainer::const_iterator it = requests_.begin();
+         it != requests_.end(); ++it)
+    {
+        s << "CID " << it->first << ": " << it->second.bits << " bits, "
+          << it->second.pdus << " PDUs\n";
+    }
+    return s.str();
+}
+
+wns::ldk::CompoundPtr
+BWRequestQueue::createPlaceholder(wns::scheduler::ConnectionID cid, Bit bits)
+{
+    assure(friends_.classifier, "wimac::BWRequestQueue: classifier not set");
+
+    wns::ldk::CompoundPtr compound(
+        new wns::ldk::Compound(fun_->getProxy()->createCommandPool(),
+                               wns::ldk::helper::FakePDUPtr(new wns::ldk::helper::FakePDU(bits))));
+
+    wns::ldk::ClassifierCommand* command =
+        friends_.classifier->activateCommand(compound->getCommandPool());
+    command->peer.id = cid;
+
+    return compound;
+}
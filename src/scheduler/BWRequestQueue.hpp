@@ -0,0 +1,204 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_SCHEDULER_BWREQUESTQUEUE_HPP
+#define WIMAC_SCHEDULER_BWREQUESTQUEUE_HPP
+
+#include <WNS/scheduler/queue/QueueInterface.hpp>
+#include <WNS/ldk/Classifier.hpp>
+#include <WNS/simulator/Bit.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <map>
+
+namespace wns { namespace ldk {
+    class HasReceptorInterface;
+    }}
+
+namespace wimac { namespace scheduler {
+
+    /**
+     * @brief Queue of aggregated bandwidth requests for the UL master
+     * scheduler.
+     *
+     * Instead of one compound per PDU backlogged at a subscriber station,
+     * the queue stores one descriptor (number of bits and PDUs) per CID.
+     * The descriptors are written by the PseudoBWRequestGenerator once per
+     * frame. Compounds are only created for the PDUs / segments the
+     * strategy actually grants resources to, so the number of compounds
+     * per frame is bounded by the frame capacity and not by the backlog of
+     * the subscriber stations.
+     */
+    class BWRequestQueue:
+        public wns::scheduler::queue::QueueInterface,
+        boost::noncopyable
+    {
+    public:
+        /**
+         * @brief Aggregated bandwidth request of one connection
+         */
+        struct BWRequest
+        {
+            BWRequest() :
+                user(),
+                bits(0),
+                pdus(0)
+            {}
+
+            wns::scheduler::UserID user;
+            Bit bits;
+            unsigned long int pdus;
+        };
+
+        typedef std::map<wns::scheduler::ConnectionID, BWRequest> BWRequestContainer;
+
+        BWRequestQueue(wns::ldk::HasReceptorInterface* parent, const wns::pyconfig::View& config);
+
+        /**
+         * @brief Replaces the bandwidth request of cid by the given one.
+         *
+         * A request for zero PDUs removes the entry. Requests for more
+         * than maxSize PDUs are cut to maxSize PDUs of the same average
+         * size.
+         */
+        void
+        setBWRequest(wns::scheduler::ConnectionID cid,
+                     wns::scheduler::UserID user,
+                     unsigned long int pdus,
+                     Bit bits);
+
+        const BWRequestContainer&
+        getBWRequests() const;
+
+        bool
+        queueHasPDUs(wns::scheduler::ConnectionID cid) const;
+
+        bool
+        isEmpty() const;
+
+        wns::scheduler::ConnectionSet
+        filterQueuedCids(wns::scheduler::ConnectionSet connections);
+
+        /**
+         * @brief Creates a placeholder compound of the average PDU size
+         * of the request and removes it from the descriptor.
+         */
+        wns::ldk::CompoundPtr
+        getHeadOfLinePDU(wns::scheduler::ConnectionID cid);
+
+        int
+        getHeadOfLinePDUbits(wns::scheduler::ConnectionID cid);
+
+        bool
+        hasQueue(wns::scheduler::ConnectionID cid);
+
+        ProbeOutput
+        resetAllQueues();
+
+        ProbeOutput
+        resetQueues(wns::scheduler::UserID user);
+
+        ProbeOutput
+        resetQueue(wns::scheduler::ConnectionID cid);
+
+        void
+        frameStarts();
+
+        bool
+        supportsDynamicSegmentation() const;
+
+        /**
+         * @brief Creates a placeholder compound of at most bits and
+         * removes the granted bits from the descriptor.
+         */
+        wns::ldk::CompoundPtr
+        getHeadOfLinePDUSegment(wns::scheduler::ConnectionID cid, int bits);
+
+        wns::scheduler::UserSet
+        getQueuedUsers() const;
+
+        wns::scheduler::ConnectionSet
+        getActiveConnections() const;
+
+        wns::scheduler::ConnectionSet
+        getActiveConnectionsForPriority(unsigned int priority) const;
+
+        unsigned long int
+        numCompoundsForCid(wns::scheduler::ConnectionID cid) const;
+
+        unsigned long int
+        numBitsForCid(wns::scheduler::ConnectionID cid) const;
+
+        wns::scheduler::QueueStatusContainer
+        getQueueStatus(bool forFuture) const;
+
+        /**
+         * @brief Bandwidth requests are not queued as compounds, so
+         * nothing is accepted.
+         */
+        bool
+        isAccepting(const wns::ldk::CompoundPtr&) const;
+
+        void
+        put(const wns::ldk::CompoundPtr& compound);
+
+        std::queue<wns::ldk::CompoundPtr>
+        getQueueCopy(wns::scheduler::ConnectionID cid);
+
+        void
+        setColleagues(wns::scheduler::RegistryProxyInterface* registry);
+
+        void
+        setFUN(wns::ldk::fun::FUN* fun);
+
+        std::string
+        printAllQueues();
+
+    private:
+        wns::ldk::CompoundPtr
+        createPlaceholder(wns::scheduler::ConnectionID cid, Bit bits);
+
+        ProbeOutput
+        erase(BWRequestContainer::iterator it);
+
+        BWRequestContainer requests_;
+        unsigned long int maxSize_;
+
+        wns::ldk::fun::FUN* fun_;
+
+        struct {
+            std::string classifierName;
+            wns::ldk::CommandTypeSpecifier<wns::ldk::ClassifierCommand>* classifier;
+        } friends_;
+
+        struct {
+            wns::scheduler::RegistryProxyInterface* registry;
+        } colleagues_;
+    };
+
+}} // namespace wimac::scheduler
+
+#endif // WIMAC_SCHEDULER_BWREQUESTQUEUE_HPP
@@ -55,7 +55,8 @@ DLCallback::DLCallback(wns::ldk::fun::FUN* fun, const wns::pyconfig::View& confi
     fun_(fun),
     beamforming(config.get<bool>("beamforming")),
     slotLength_(config.get<wns::simulator::Time>("slotLength")),
-    tbCounter_(0)
+    tbCounter_(0),
+    timeSlotOffset_(0)
 {}
 
 void DLCallback::deliverNow(wns::ldk::Connector* connector)
@@ -113,6 +114,11 @@ DLCallback::callBack(wns::scheduler::SchedulingMapPtr schedulingMap)
             {
                 if ( iterPRB->hasScheduledCompounds() )
                 {
+                    // HARQ handles the resource as one transport block, no
+                    // matter how many compounds it carries. Stored first, so
+                    // the copies in the compounds carry the HARQ state.
+                    colleagues.harq->storeSchedulingTimeSlot(tbCounter_, timeSlotPtr);
+
                     wns::scheduler::ScheduledCompoundsList::const_iterator it;
                     
                     for(it = iterPRB->scheduledCompoundsBegin();
@@ -121,6 +127,7 @@ DLCallback::callBack(wns::scheduler::SchedulingMapPtr schedulingMap)
                     { // for every compound in subchannel:
                         processPacket(*it, timeSlotPtr);
                     } // for (all scheduledCompounds)
+
                     iterPRB->clearScheduledCompounds();
                 } // if there were compounds in this resource
             } // forall beams
@@ -143,7 +150,7 @@ DLCallback::processPacket(const wns::scheduler::SchedulingCompound & compound,
     wns::service::phy::phymode::PhyModeInterfacePtr phyModePtr = compound.phyModePtr;
     wns::service::phy::ofdma::PatternPtr pattern = compound.pattern;
 
-    simTimeType timeSlotOffset = timeSlot * slotLength_;
+    simTimeType timeSlotOffset = (timeSlotOffset_ + timeSlot) * slotLength_;
     startTime += timeSlotOffset;
     endTime += timeSlotOffset;
 
@@ -248,11 +255,49 @@ DLCallback::processPacket(const wns::scheduler::SchedulingCompound & compound,
     phyCommand->peer.estimatedCQI = estimatedCQI;
     phyCommand->magic.sourceComponent_ = wimacComponent;
 
-    colleagues.harq->storeSchedulingTimeSlot(tbCounter_, timeSlotPtr);
-
     phyCommand->magic.schedulingTimeSlot = wns::scheduler::SchedulingTimeSlotPtr(
         new wns::scheduler::SchedulingTimeSlot(*timeSlotPtr));
 
     scheduledPDUs.push(pdu);
 }
 
+void
+DLCallback::scheduleBroadcast(const wns::ldk::CompoundPtr& pdu,
+                              int timeSlot,
+                              int numberOfTimeSlots,
+                              simTimeType slotLength,
+                              simTimeType startTime,
+                              simTimeType endTime,
+                              wns::service::phy::phymode::PhyModeInterfacePtr phyModePtr)
+{
+    assure(pdu != wns::ldk::CompoundPtr(), "Invalid empty PDU");
+
+    LOG_INFO(fun_->getLayer()->getName(), " DLCallback::scheduleBroadcast() in ",
+             numberOfTimeSlots, " time slots from ", startTime, " to ", endTime);
+
+    // one transmission for the whole region, like the MAPs
+    BroadcastPhyAccessFunc* broadcastFunc = new BroadcastPhyAccessFunc;
+    broadcastFunc->transmissionStart_ = startTime;
+    broadcastFunc->transmissionStop_ = endTime - Utilities::getComputationalAccuracyFactor();
+    broadcastFunc->timeSlot_ = timeSlot;
+
+    wimac::PhyUserCommand* phyCommand = dynamic_cast<wimac::PhyUserCommand*>(
+        fun_->getProxy()->activateCommand( pdu->getCommandPool(), friends_.phyUser ) );
+
+    phyCommand->local.pAFunc_.reset( broadcastFunc );
+    phyCommand->local.pAFunc_->phyMode_ = phyModePtr;
+
+    wimac::Component* wimacComponent = dynamic_cast<wimac::Component*>(fun_->getLayer());
+    phyCommand->peer.destination_ = NULL;
+    phyCommand->peer.cellID_ = wimacComponent->getCellID();
+    phyCommand->peer.source_ = wimacComponent->getNode();
+    phyCommand->peer.phyModePtr = phyModePtr;
+    phyCommand->peer.measureInterference_ = false;
+    phyCommand->magic.sourceComponent_ = wimacComponent;
+
+    // Receivers keep broadcasts out of HARQ, see DataCollector::doOnData
+    phyCommand->magic.schedulingTimeSlot = wns::scheduler::SchedulingTimeSlotPtr(
+        new wns::scheduler::SchedulingTimeSlot(0, timeSlot, 1, numberOfTimeSlots * slotLength));
+
+    scheduledPDUs.push(pdu);
+}
@@ -28,6 +28,8 @@
 
 #include <WIMAC/scheduler/Callback.hpp>
 
+#include <WNS/service/phy/phymode/PhyModeInterface.hpp>
+
 namespace wimac { namespace scheduler {
 
     class DLCallback :
@@ -42,6 +44,31 @@ namespace wimac { namespace scheduler {
         void 
         deliverNow(wns::ldk::Connector*);
 
+        /**
+         * @brief Schedule a broadcast compound as one transmission over
+         * all subchannels of numberOfTimeSlots time slots starting at
+         * timeSlot, from startTime to endTime (relative to the start of
+         * the phase).
+         */
+        void
+        scheduleBroadcast(const wns::ldk::CompoundPtr& pdu,
+                          int timeSlot,
+                          int numberOfTimeSlots,
+                          simTimeType slotLength,
+                          simTimeType startTime,
+                          simTimeType endTime,
+                          wns::service::phy::phymode::PhyModeInterfacePtr phyModePtr);
+
+        /**
+         * @brief Time slot index added to the time slots of the
+         * scheduling maps passed to callBack.
+         */
+        void
+        setTimeSlotOffset(int timeSlotOffset)
+        {
+            timeSlotOffset_ = timeSlotOffset;
+        }
+
     private:
         void
         processPacket(const wns::scheduler::SchedulingCompound& compound,
@@ -51,6 +78,7 @@ namespace wimac { namespace scheduler {
         bool beamforming;
         wns::simulator::Time slotLength_;
 	long int tbCounter_;
+        int timeSlotOffset_;
     };
 
 }}
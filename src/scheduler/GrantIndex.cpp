@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/scheduler/GrantIndex.hpp>
+
+using namespace wimac::scheduler;
+
+GrantIndex::GrantIndex(const wns::scheduler::SchedulingMapPtr& schedulingMap)
+{
+    if (schedulingMap == wns::scheduler::SchedulingMapPtr())
+        return;
+
+    for (std::size_t subChannel = 0; subChannel < schedulingMap->subChannels.size(); ++subChannel)
+    {
+        const wns::scheduler::SchedulingTimeSlotPtrVector& timeSlots =
+            schedulingMap->subChannels[subChannel].temporalResources;
+
+        for (std::size_t timeSlot = 0; timeSlot < timeSlots.size(); ++timeSlot)
+        {
+            const wns::scheduler::PhysicalResourceBlockVector& prbs = timeSlots[timeSlot]->physicalResources;
+
+            for (std::size_t beam = 0; beam < prbs.size(); ++beam)
+            {
+                if (!prbs[beam].hasScheduledCompounds())
+                    continue;
+
+                UserGrants& userGrants = users_[prbs[beam].scheduledCompoundsBegin()->userID];
+
+                if (userGrants.grants.empty())
+                    userGrants.estimatedCQI = prbs[beam].getEstimatedCQI();
+
+                // extend the range of the previous time slot if possible
+                if (!userGrants.grants.empty())
+                {
+                    Grant& last = userGrants.grants.back();
+                    if (last.subChannel == int(subChannel)
+                        && last.beam == int(beam)
+                        && last.lastTimeSlot + 1 == int(timeSlot))
+                    {
+                        last.lastTimeSlot = timeSlot;
+                        continue;
+                    }
+                }
+
+                Grant grant;
+                grant.subChannel = subChannel;
+                grant.firstTimeSlot = timeSlot;
+                grant.lastTimeSlot = timeSlot;
+                grant.beam = beam;
+                userGrants.grants.push_back(grant);
+            }
+        }
+    }
+}
+
+bool
+GrantIndex::hasGrants(const wns::scheduler::UserID& user) const
+{
+    return users_.find(user) != users_.end();
+}
+
+const GrantIndex::UserGrants*
+GrantIndex::find(const wns::scheduler::UserID& user) const
+{
+    UserMap::const_iterator it = users_.find(user);
+    if (it == users_.end())
+        return NULL;
+
+    return &it->second;
+}
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_SCHEDULER_GRANTINDEX_HPP
+#define WIMAC_SCHEDULER_GRANTINDEX_HPP
+
+#include <WNS/SmartPtr.hpp>
+#include <WNS/scheduler/SchedulingMap.hpp>
+
+#include <map>
+#include <vector>
+
+namespace wimac { namespace scheduler {
+
+        /**
+         * @brief The UL grants of one frame, indexed by user.
+         *
+         * Built once per frame by the UL master scheduler and sent with the
+         * UL-MAP, so that each UT finds its grants without scanning the
+         * whole SchedulingMap.
+         */
+        class GrantIndex :
+            public wns::RefCountable
+        {
+        public:
+            /**
+             * @brief Consecutive time slots granted on one subchannel and
+             * beam.
+             */
+            struct Grant
+            {
+                int subChannel;
+                int firstTimeSlot;
+                int lastTimeSlot;
+                int beam;
+            };
+            typedef std::vector<Grant> Grants;
+
+            struct UserGrants
+            {
+                Grants grants;
+                /** @brief Estimated CQI of the first granted resource */
+                wns::scheduler::ChannelQualityOnOneSubChannel estimatedCQI;
+            };
+
+            /**
+             * @brief Index the resources of schedulingMap that carry
+             * scheduled compounds.
+             */
+            explicit
+            GrantIndex(const wns::scheduler::SchedulingMapPtr& schedulingMap);
+
+            bool
+            hasGrants(const wns::scheduler::UserID& user) const;
+
+            /**
+             * @brief The grants of user, NULL if it has none.
+             */
+            const UserGrants*
+            find(const wns::scheduler::UserID& user) const;
+
+            /** @brief Number of users with grants */
+            std::size_t
+            size() const
+            {
+                return users_.size();
+            }
+
+        private:
+            typedef std::map<wns::scheduler::UserID, UserGrants> UserMap;
+
+            UserMap users_;
+        };
+
+        typedef wns::SmartPtr<GrantIndex> GrantIndexPtr;
+}}
+
+#endif // WIMAC_SCHEDULER_GRANTINDEX_HPP
@@ -30,17 +30,16 @@
 #include <WIMAC/scheduler/PseudoBWRequestGenerator.hpp>
 #include <WIMAC/services/ConnectionManager.hpp>
 #include <WIMAC/ConnectionIdentifier.hpp>
-#include <WIMAC/Classifier.hpp>
+#include <WIMAC/scheduler/BWRequestQueue.hpp>
 #include <WIMAC/scheduler/Scheduler.hpp>
 #include <WIMAC/StationManager.hpp>
 
 #include <WNS/StaticFactory.hpp>
 
 #include <WNS/scheduler/SchedulerTypes.hpp>
-#include <WNS/ldk/helper/FakePDU.hpp>
 #include <WNS/scheduler/queue/QueueInterface.hpp>
 
-#include <map>
+#include <set>
 
 using namespace wns;
 using namespace wns::ldk;
@@ -59,11 +58,10 @@ PseudoBWRequestGenerator::PseudoBWRequestGenerator( const wns::pyconfig::View& c
     packetSize += config.get<int>("pduOverhead");
 
     friends_.connectionManagerName = config.get<std::string>("connectionManager");
-    friends_.classifierName = config.get<std::string>("classifier");
 
     friends_.connectionManager = NULL;
     friends_.ulScheduler = NULL;
-    friends_.classifier = NULL;
+    friends_.bwRequestQueue = NULL;
 }
 
 void PseudoBWRequestGenerator::setFUN(wns::ldk::fun::FUN* fun)
@@ -82,8 +80,9 @@ PseudoBWRequestGenerator::setScheduler(wimac::scheduler::Interface* scheduler)
     friends_.ulScheduler = dynamic_cast<Scheduler*>(scheduler);
     assureNotNull(friends_.ulScheduler);
 
-    friends_.classifier = component_->getFUN()->findFriend<wimac::ConnectionClassifier*>
-        (friends_.classifierName);
+    friends_.bwRequestQueue = dynamic_cast<BWRequestQueue*>(friends_.ulScheduler->getQueue());
+    assure(friends_.bwRequestQueue,
+           "PseudoBWRequestGenerator needs a wimac.BWRequestQueue in the UL scheduler");
 }
 
 /** @brief Indicates upgoing connections.
@@ -105,13 +104,15 @@ private:
 
 /**
  * @brief On doWakeup(), a list of all CIDs of registered connections is retrieved
- * from the ConnectionManager. Then, one "Fake"-PDU is created for every
- * user and given to the lower FU which should be a generic scheduler operating
- * in UL-mode.
+ * from the ConnectionManager. Then, one aggregated bandwidth request (bits and
+ * PDUs) is stored for every peer station in the BWRequestQueue of the UL
+ * scheduler, on the first of its basic connections.
+ * No compounds are created here, the queue only creates them for the
+ * resources the strategy actually grants.
  */
 void
 PseudoBWRequestGenerator::wakeup() {
-    // Delete all old fake packets from last generation, because fake pdus (aquivalent to peerQueues) is generated every frame.
+    // Bandwidth requests are regenerated every frame, drop the old ones
     friends_.ulScheduler->resetAllQueues();
 
     ConnectionIdentifiers allBasicConnIDs =
@@ -119,15 +120,10 @@ PseudoBWRequestGenerator::wakeup() {
 
     allBasicConnIDs.remove_if( UpgoingConnection( component_->getID()) );
 
-    std::map<wns::scheduler::UserID, ConnectionIdentifier::CID> userIDs;
-    userIDs.clear();
-
-    // FIXME BWrequest shortcut.
-    std::map<wns::scheduler::UserID, int> peerQueuePDUSize;
-    peerQueuePDUSize.clear();
-
-    // first get a list of users having registered connections and one of the
-    // respective CIDs.
+    // An RS holds a basic connection for itself and one for every UT
+    // behind it, all with the RS as subscriber station. Its backlog is
+    // requested once.
+    std::set<ConnectionIdentifier::StationID> requested;
 
     for (ConnectionIdentifier::List::const_iterator iter = allBasicConnIDs.begin();
          iter != allBasicConnIDs.end(); ++iter) {
@@ -138,6 +134,8 @@ PseudoBWRequestGenerator::wakeup() {
             continue;
 
         ConnectionIdentifier::StationID peerStationId = cidPtr->subscriberStation_;
+        if (!requested.insert(peerStationId).second)
+            continue;
 
         Component* peerComponent = dynamic_cast<wimac::Component*>(
             TheStationManager::getInstance()->getStationByID(peerStationId) );
@@ -151,32 +149,13 @@ PseudoBWRequestGenerator::wakeup() {
         int queueSize = peerComponent->getNumberOfQueuedPDUs(cis);
         if(queueSize == 0)
             continue;
-        peerQueuePDUSize[wns::scheduler::UserID(peerComponent->getNode())] = queueSize;
 
-        userIDs[wns::scheduler::UserID(peerComponent->getNode())] = cidPtr->getID();
-    }
+        LOG_INFO(component_->getName(), " PseudoBWReqGenerator: bandwidth request of ",
+                 queueSize, " PDUs for CID ", cidPtr->getID());
 
-    // then create PDUs for every user and hand them down to the lower layer
-    for (std::map<wns::scheduler::UserID, ConnectionIdentifier::CID>::const_iterator iter = userIDs.begin();
-         iter != userIDs.end(); ++iter) {
-        LOG_INFO(component_->getName(), " PseudoBWReqGenerator: is going to generate ",
-                 peerQueuePDUSize[iter->first], " Fake PDUs for CID ", iter->second);
-        for( int i = 1; i <= peerQueuePDUSize[iter->first]; ++i)
-        {
-            CompoundPtr pdu =
-                CompoundPtr(new Compound(component_->getFUN()->getProxy()->createCommandPool(),
-                                         wns::ldk::helper::FakePDUPtr(new helper::FakePDU(packetSize))));
-
-            wns::ldk::ClassifierCommand* command =
-                friends_.classifier->activateCommand(pdu->getCommandPool());
-            command->peer.id = iter->second;
-
-            if(friends_.ulScheduler->isAccepting(pdu)){
-                friends_.ulScheduler->schedule(pdu);
-                LOG_TRACE(component_->getFUN()->getName(), " PseudoBWRequestGenerator: generated a Fake PDU for CID ", iter->second);
-            }
-            else
-                break;
-        }
+        friends_.bwRequestQueue->setBWRequest(cidPtr->getID(),
+                                              wns::scheduler::UserID(peerComponent->getNode()),
+                                              queueSize,
+                                              queueSize * packetSize);
     }
 }
@@ -44,8 +44,15 @@ namespace wimac { namespace scheduler {
 
 	class Scheduler;
 	class Interface;
+	class BWRequestQueue;
 
-	/// A generator of pseude BW reqeusts that can be used by the BSScheduler.
+	/**
+	 * @brief A generator of pseudo BW requests that can be used by the
+	 * BSScheduler.
+	 *
+	 * The requests are aggregated per CID and written into the
+	 * BWRequestQueue of the UL scheduler.
+	 */
 	class PseudoBWRequestGenerator :
 		public wns::Cloneable<PseudoBWRequestGenerator>
 	{
@@ -62,11 +69,10 @@ namespace wimac { namespace scheduler {
 
 		struct {
 			std::string connectionManagerName;
-			std::string classifierName;
 
 			service::ConnectionManager* connectionManager;
 			wimac::scheduler::Scheduler* ulScheduler;
-			wimac::ConnectionClassifier* classifier;
+			wimac::scheduler::BWRequestQueue* bwRequestQueue;
 		} friends_;
 
 		int packetSize;
@@ -40,8 +40,12 @@
 #include <WIMAC/parameter/PHY.hpp>
 #include <WIMAC/services/ConnectionManager.hpp>
 #include <WIMAC/services/InterferenceCache.hpp>
+#include <WIMAC/services/LinkAdaptation.hpp>
 #include <WIMAC/ConnectionIdentifier.hpp>
 #include <WIMAC/frame/ULMapCollector.hpp>
+#include <WIMAC/relay/RelayMapper.hpp>
+
+#include <algorithm>
 
 
 using namespace wimac;
@@ -61,7 +65,25 @@ RegistryProxyWiMAC::RegistryProxyWiMAC(wns::ldk::fun::FUN*, const wns::pyconfig:
           isDL_(config.get<bool>("isDL")),
           mapHandler(0)
 {
+	linkAdaptation = NULL;
+	if (config.knows("linkAdaptation") && !config.isNone("linkAdaptation"))
+		linkAdaptationName = config.get<std::string>("linkAdaptation");
+
+	relayCoordination = false;
+	relayDrainTimeLimit = 0.0;
+	relayBacklogPerUser = 0;
+	if (config.knows("relayCoordination") && !config.isNone("relayCoordination"))
+	{
+		relayCoordination = true;
+		relayDrainTimeLimit = config.getView("relayCoordination").get<simTimeType>("drainTimeLimit");
+		relayBacklogPerUser = config.getView("relayCoordination").get<Bit>("backlogPerUser");
+		assure(relayBacklogPerUser > 0, "backlogPerUser must be positive");
+	}
+
 	//phyModeMapper.reset(wns::service::phy::phymode::createPhyModeMapper(config.getView("phyModeMapper")));// obsolete
+
+	if (config.knows("phyModeTable") && !config.isNone("phyModeTable"))
+		phyModeTable = PhyModeTable::getTable(phyModeMapper, config.getView("phyModeTable"));
 }
 
 wns::scheduler::UserID
@@ -218,6 +240,9 @@ RegistryProxyWiMAC::setFUN(const wns::ldk::fun::FUN* _fun) {
             mapHandler = fun->findFriend< wimac::frame::MapHandlerInterface*>("ulmapcollector");
             assure( mapHandler, "mapcollector not of type wimac::scheduler::MapHandler");
         }
+
+	if (!linkAdaptationName.empty())
+		linkAdaptation = layer2->getManagementService<service::LinkAdaptation>(linkAdaptationName);
 }
 
 std::string
@@ -252,9 +277,18 @@ RegistryProxyWiMAC::getPhyModeMapper() const
 wns::SmartPtr<const wns::service::phy::phymode::PhyModeInterface>
 RegistryProxyWiMAC::getBestPhyMode(const wns::Ratio& sinr)
 {
+	if (phyModeTable != PhyModeTablePtr())
+		return phyModeTable->getBestPhyMode(sinr);
+
 	return getPhyModeMapper()->getBestPhyMode(sinr);
 }
 
+PhyModeTable*
+RegistryProxyWiMAC::getPhyModeTable() const
+{
+	return phyModeTable.getPtr();
+}
+
 wns::scheduler::UserID
 RegistryProxyWiMAC::getMyUserID()
 {
@@ -286,7 +320,11 @@ RegistryProxyWiMAC::estimateTxSINRAt(const wns::scheduler::UserID user, int slot
         wns::Power carrier =
         layer2->getManagementService<service::InterferenceCache>("interferenceCache")
             ->getAveragedCarrier(user.getNode());
-        return wns::scheduler::ChannelQualityOnOneSubChannel(pathloss, interference, carrier);
+
+        wns::scheduler::ChannelQualityOnOneSubChannel estimate(pathloss, interference, carrier);
+        if (linkAdaptation != NULL)
+            return linkAdaptation->correct(user.getNode(), service::LinkAdaptation::Transmit, estimate);
+        return estimate;
     } else {
         //lookup results signaled by the BS-master through the MAP
         return mapHandler->getEstimatedCQI();
@@ -307,7 +345,10 @@ RegistryProxyWiMAC::estimateRxSINROf(const wns::scheduler::UserID user, int slot
     wns::Power interference = remoteCache->getAveragedInterference(getMyUserID().getNode());
     wns::Power carrier = remoteCache->getAveragedCarrier(getMyUserID().getNode());
 
-    return wns::scheduler::ChannelQualityOnOneSubChannel(pathloss, interference, carrier);
+    wns::scheduler::ChannelQualityOnOneSubChannel estimate(pathloss, interference, carrier);
+    if (linkAdaptation != NULL)
+        return linkAdaptation->correct(user.getNode(), service::LinkAdaptation::Receive, estimate);
+    return estimate;
 }
 
 wns::scheduler::Bits
@@ -448,7 +489,93 @@ RegistryProxyWiMAC::filterReachable(wns::scheduler::UserSet users)
 wns::scheduler::ConnectionSet
 RegistryProxyWiMAC::filterReachable(wns::scheduler::ConnectionSet connections, const int /*frameNr*/, bool /*useHARQ*/)
 {
-       return connections;
+    assure(connManager, "No valid connection manager");
+
+    bool holdBackRelays = relayCoordination && isDL_
+        && layer2->getStationType() == wns::service::dll::StationTypes::AP();
+
+    // connections of sleeping stations stay queued
+    if (connManager->allListening() && !holdBackRelays)
+        return connections;
+
+    wns::scheduler::ConnectionSet result;
+    for (wns::scheduler::ConnectionSet::const_iterator it = connections.begin();
+         it != connections.end(); ++it)
+    {
+        if (!connManager->isListening(*it))
+            continue;
+
+        // the RS still has enough to forward for this connection
+        if (holdBackRelays && getRelayDrainTime(*it) > relayDrainTimeLimit)
+        {
+            LOG_INFO("RegistryProxy in station ", layer2->getID(),
+                     " holds back relay connection ", *it);
+            continue;
+        }
+
+        result.insert(*it);
+    }
+    return result;
+}
+
+Component*
+RegistryProxyWiMAC::getRelayMapping(wns::scheduler::ConnectionID cid,
+                                    ConnectionIdentifier::CID& accessCID)
+{
+    ConnectionIdentifierPtr ci = connManager->getConnectionWithID(cid);
+    if (ci == ConnectionIdentifierPtr())
+        return NULL;
+
+    Component* relay = dynamic_cast<wimac::Component*>
+        ( TheStationManager::getInstance()->getStationByID(ci->subscriberStation_) );
+    if (relay == NULL
+        || relay->getStationType() != wns::service::dll::StationTypes::FRS())
+        return NULL;
+
+    relay::RSRelayMapper* relayMapper =
+        relay->getFUN()->findFriend<relay::RSRelayMapper*>("relayMapper");
+    assure(relayMapper, "RS " << relay->getName() << " has no RSRelayMapper");
+
+    relay::RSRelayMapper::RelayMapping mapping = relayMapper->findMapping(cid);
+    if (mapping == relay::RSRelayMapper::RelayMapping())
+        return NULL;
+
+    accessCID = mapping.getLowerConnection();
+    return relay;
+}
+
+simTimeType
+RegistryProxyWiMAC::getRelayDrainTime(wns::scheduler::ConnectionID cid)
+{
+    ConnectionIdentifier::CID accessCID;
+    Component* relay = getRelayMapping(cid, accessCID);
+    if (relay == NULL)
+        return 0.0;
+
+    Bit backlog = relay->getQueueOccupancy(accessCID).bits;
+    if (backlog == 0)
+        return 0.0;
+
+    // channel quality of the access link as reported to the RS
+    ConnectionIdentifierPtr accessCI =
+        relay->getManagementService<service::ConnectionManager>("connectionManager")
+        ->getConnectionWithID(accessCID);
+    assure(accessCI != ConnectionIdentifierPtr(), "RS knows no access connection " << accessCID);
+
+    Component* subscriber = dynamic_cast<wimac::Component*>
+        ( TheStationManager::getInstance()->getStationByID(accessCI->subscriberStation_) );
+    assure(subscriber, "Invalid subscriber layer pointer");
+
+    service::InterferenceCache* relayCache =
+        relay->getManagementService<service::InterferenceCache>("interferenceCache");
+    wns::Power interference = relayCache->getAveragedInterference(subscriber->getNode());
+    assure(interference.get_mW() > 0.0,
+           "RS " << relay->getName() << " has no interference estimate for "
+           << subscriber->getName());
+
+    wns::Ratio sinr = relayCache->getAveragedCarrier(subscriber->getNode()) / interference;
+
+    return backlog / getBestPhyMode(sinr)->getDataRate();
 }
 
 wns::scheduler::PowerMap
@@ -468,21 +595,28 @@ RegistryProxyWiMAC::getActiveULUsers() const
 int
 RegistryProxyWiMAC::getTotalNumberOfUsers(wns::scheduler::UserID user)
 {
-/*	ConnectionIdentifiers conns = connManager->getAllBasicConnections();
-	int count = 0;
+	if (!relayCoordination || user.isBroadcast()
+		|| getStationType(user) != wns::service::dll::StationTypes::FRS())
+		return 1;
+
+	// the demand behind the RS: what it holds for the access
+	// connections of the relayed connections
+	ConnectionIdentifiers conns = connManager->getAllConnections();
+	Bit backlog = 0;
 	for (ConnectionIdentifiers::iterator it = conns.begin();
 		it != conns.end();
 		++it )
 	{
-		if (TheStationManager::getInstance()->getStationByID((*it)->subscriberStation_)->getNode() == user)
-		{
-			++count;
-		}
+		ConnectionIdentifier::CID accessCID;
+		Component* relay = getRelayMapping((*it)->getID(), accessCID);
+		if (relay != NULL && relay->getNode() == user.getNode())
+			backlog += relay->getQueueOccupancy(accessCID).bits;
 	}
-	assure(count>0, "No basic connection for user " << user->getName() << " found.");
-	LOG_INFO("getTotalNumberOfUsers(): ", count, " users");
-	return count;*/
-	return 1;
+
+	int weight = 1 + int(backlog / relayBacklogPerUser);
+	LOG_INFO("getTotalNumberOfUsers(): RS weighted as ", weight,
+			 " users for ", backlog, " bits of access backlog");
+	return weight;
 }
 
 void
@@ -32,7 +32,9 @@
 #include <WIMAC/ConnectionIdentifier.hpp>
 #include <WIMAC/Component.hpp>
 #include <WIMAC/Logger.hpp>
+#include <WIMAC/PhyModeTable.hpp>
 #include <WNS/scheduler/RegistryProxyInterface.hpp>
+#include <WNS/simulator/Bit.hpp>
 #include <WNS/service/dll/StationTypes.hpp>
 #include <WNS/service/phy/phymode/PhyModeMapperInterface.hpp>
 #include <WNS/StaticFactory.hpp>
@@ -43,6 +45,9 @@ namespace wimac {
     namespace frame {
         class MapHandlerInterface;
     }
+    namespace service {
+        class LinkAdaptation;
+    }
     namespace scheduler {
 
 	class Scheduler;
@@ -67,6 +72,10 @@ namespace wimac {
 		std::string getNameForUser(const wns::scheduler::UserID user);
 		wns::service::phy::phymode::PhyModeMapperInterface* getPhyModeMapper() const;
 		wns::SmartPtr<const wns::service::phy::phymode::PhyModeInterface> getBestPhyMode(const wns::Ratio&);
+		/**
+		 * @brief The constant time PhyMode selection, NULL if not configured
+		 */
+		PhyModeTable* getPhyModeTable() const;
 		wns::scheduler::UserID getMyUserID();
 		simTimeType getOverhead(int numBursts);
 		wns::scheduler::ChannelQualityOnOneSubChannel estimateTxSINRAt(
@@ -80,7 +89,9 @@ namespace wimac {
 		virtual wns::scheduler::ConnectionSet filterReachable(wns::scheduler::ConnectionSet connections, const int frameNr, bool useHARQ );
 		virtual wns::scheduler::PowerMap calcULResources(const wns::scheduler::UserSet&, unsigned long int) const;
 		virtual wns::scheduler::UserSet getActiveULUsers() const;
-		/**@brief returns one for UTs, and #connected UTs in case of RNs */
+		/**@brief returns one for UTs. With relay coordination, an RS
+		 * counts as one user plus one per relayBacklogPerUser bits waiting
+		 * at the RS for its access connections. */
 		virtual int getTotalNumberOfUsers(const wns::scheduler::UserID user);
 		void switchFilterTo(int qos);
         void 
@@ -157,6 +168,22 @@ namespace wimac {
 		wns::ldk::fun::FUN* fun;
 		wimac::Component* layer2;
 		service::ConnectionManager* connManager;
+		/**
+		 * @brief Applies the OLLA offsets to the SINR estimates, NULL if
+		 * not configured
+		 */
+		service::LinkAdaptation* linkAdaptation;
+		std::string linkAdaptationName;
+
+		/**
+		 * @brief The BS holds back relay connections whose backlog at
+		 * the RS needs more than relayDrainTimeLimit to be drained on
+		 * one subchannel of the access link, and weights each RS by
+		 * the backlog it holds for the access link.
+		 */
+		bool relayCoordination;
+		simTimeType relayDrainTimeLimit;
+		Bit relayBacklogPerUser;
 
 		///\todo remove this when node->getComponent can deliver Layer2
 		std::map<wns::scheduler::UserID, ConnectionIdentifier::StationID> userId2StationId;
@@ -167,6 +194,7 @@ namespace wimac {
 
 		//std::auto_ptr<wns::service::phy::phymode::PhyModeMapperInterface> phyModeMapper;
 		wns::service::phy::phymode::PhyModeMapperInterface* phyModeMapper;
+		PhyModeTablePtr phyModeTable;
 
 		const int queueSize;
 
@@ -176,6 +204,20 @@ namespace wimac {
 		wns::scheduler::UserSet filterListening( wns::scheduler::UserSet users );
 		wns::scheduler::UserSet filterQoSbased( wns::scheduler::UserSet users );
 
+		/**
+		 * @brief Airtime on one subchannel the RS needs to forward
+		 * what it already holds for this relay connection, 0 if cid
+		 * does not lead to an RS.
+		 */
+		simTimeType getRelayDrainTime(wns::scheduler::ConnectionID cid);
+
+		/**
+		 * @brief The RS cid leads to, NULL if it does not lead to an
+		 * RS. accessCID is set to the CID the RS maps cid to.
+		 */
+		Component* getRelayMapping(wns::scheduler::ConnectionID cid,
+								   ConnectionIdentifier::CID& accessCID);
+
 		wns::scheduler::PowerCapabilities powerUT;
 		wns::scheduler::PowerCapabilities powerAP;
 		wns::scheduler::PowerCapabilities powerFRS;
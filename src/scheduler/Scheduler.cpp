@@ -28,7 +28,12 @@
 
 #include <WIMAC/scheduler/Scheduler.hpp>
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+
 #include <WNS/ldk/Compound.hpp>
+#include <WNS/simulator/Bit.hpp>
 #include <WNS/ldk/Deliverer.hpp>
 #include <WNS/service/phy/ofdma/Handler.hpp>
 #include <WNS/scheduler/strategy/Strategy.hpp>
@@ -41,6 +46,7 @@
 #include <WIMAC/Utilities.hpp>
 #include <WIMAC/scheduler/PseudoBWRequestGenerator.hpp>
 #include <WIMAC/scheduler/Callback.hpp>
+#include <WIMAC/scheduler/DLCallback.hpp>
 #include <WIMAC/parameter/PHY.hpp>
 #include <WIMAC/scheduler/RegistryProxyWiMAC.hpp>
 #include <WIMAC/FUConfigCreator.hpp>
@@ -63,6 +69,8 @@ Scheduler::Scheduler(wns::ldk::FunctionalUnit* parent, const wns::pyconfig::View
 	maxBeams(config.get<int>("maxBeams")),
 	beamforming(config.get<bool>("beamforming")),
         numberOfTimeSlots_(config.get<int>("numberOfTimeSlots")),
+        configuredNumberOfTimeSlots_(numberOfTimeSlots_),
+        gainedTimeSlots_(0),
 	uplink(config.get<bool>("uplink")),
 	alwaysAcceptIfQueueAccepts(config.get<bool>("alwaysAcceptIfQueueAccepts")),
 	logger("W-NS", "Scheduler",
@@ -73,6 +81,11 @@ Scheduler::Scheduler(wns::ldk::FunctionalUnit* parent, const wns::pyconfig::View
 	queueName(config.get<std::string>("queue.nameInQueueFactory")),
 	registryName(config.get<std::string>("registry.nameInRegistryProxyFactory")),
 	callbackName(config.get<std::string>("callback.__plugin__")),
+	maxBroadcastTimeSlots_(config.get<int>("maxBroadcastTimeSlots")),
+	lookahead_(config.get<bool>("lookahead")),
+	lookaheadDelay_(config.get<wns::simulator::Time>("lookaheadDelay")),
+	pendingNumberOfTimeSlots_(numberOfTimeSlots_),
+	hasLookaheadSchedule_(false),
 	duration_(0.0),
 	pduCount(0),
 	frameNo(0),
@@ -100,6 +113,10 @@ Scheduler::Scheduler(wns::ldk::FunctionalUnit* parent, const wns::pyconfig::View
     colleagues.pseudoGenerator = 0;
     colleagues.callback = 0;
     colleagues.harq = 0;
+    colleagues.broadcastQueue = 0;
+
+    assure(!lookahead_ || lookaheadDelay_ < parameter::ThePHY::getInstance()->getFrameDuration(),
+           "The lookahead schedule must be computed within the frame");
 
 
     if (!config.isNone("pseudoGenerator"))
@@ -125,6 +142,9 @@ Scheduler::~Scheduler()
     if ( colleagues.queue )
         delete colleagues.queue;
 
+    if ( colleagues.broadcastQueue )
+        delete colleagues.broadcastQueue;
+
     if ( colleagues.grouper )
         delete colleagues.grouper;
 
@@ -145,26 +165,56 @@ Scheduler::~Scheduler()
 void Scheduler::schedule(const wns::ldk::CompoundPtr& compound)
 {
     assure(doIsAccepting(compound), "sendData called but not isAccepting");
+
+    if (isBroadcast(compound))
+    {
+        LOG_INFO("Forwarding accepted broadcast PDU to broadcast queue.");
+        colleagues.broadcastQueue->put(compound);
+        return;
+    }
+
     LOG_INFO("Forwarding accepted PDU to queue.");
     colleagues.queue->put(compound);
 }
 
 bool Scheduler::doIsAccepting(const wns::ldk::CompoundPtr& compound) const
 {
+    wns::scheduler::queue::QueueInterface* queue = colleagues.queue;
+
+    if (isBroadcast(compound))
+        queue = colleagues.broadcastQueue;
+
     if(alwaysAcceptIfQueueAccepts)
-	return colleagues.queue->isAccepting(compound);
+	return queue->isAccepting(compound);
     else
-        return accepting_ && colleagues.queue->isAccepting(compound);
+        return accepting_ && queue->isAccepting(compound);
+}
+
+bool
+Scheduler::isBroadcast(const wns::ldk::CompoundPtr& compound) const
+{
+    if (colleagues.broadcastQueue == NULL)
+        return false;
+
+    return friends_.classifier->getCommand(compound->getCommandPool())->peer.id
+        == ConnectionIdentifier::BroadcastCID;
 }
 
 void Scheduler::resetAllQueues()
 {
     colleagues.queue->resetAllQueues();
+
+    if (colleagues.broadcastQueue)
+        colleagues.broadcastQueue->resetAllQueues();
 }
 
 void
 Scheduler::notifyAboutConnectionDeleted(const ConnectionIdentifier cid)
 {
+    // the connection is only changed, keep its compounds
+    if( friends_.connectionManager->isChanging() )
+        return;
+
     if( colleagues.queue->hasQueue(cid.getID()) )
     {
         LOG_INFO( parent_->getFUN()->getName(),
@@ -224,6 +274,48 @@ Scheduler::deliverSchedule(wns::ldk::Connector* connector)
 
 void
 Scheduler::startScheduling()
+{
+    gainedTimeSlots_ = 0;
+
+    if (lookahead_ && schedulerSpot_ != wns::scheduler::SchedulerSpot::ULSlave())
+    {
+        // use the schedule computed during the previous frame, the very
+        // first frame is scheduled right away
+        if (!hasLookaheadSchedule_)
+            computeSchedule(lookaheadSchedule_);
+
+        applySchedule(lookaheadSchedule_);
+
+        lookaheadSchedule_ = FrameSchedule();
+        hasLookaheadSchedule_ = false;
+
+        wns::simulator::getEventScheduler()->scheduleDelay(
+            boost::bind(&Scheduler::computeLookaheadSchedule, this), lookaheadDelay_);
+        return;
+    }
+
+    FrameSchedule frameSchedule;
+    computeSchedule(frameSchedule);
+
+    if(schedulerSpot_ == wns::scheduler::SchedulerSpot::ULSlave())
+        return;
+
+    applySchedule(frameSchedule);
+}
+
+void
+Scheduler::computeLookaheadSchedule()
+{
+    LOG_INFO(parent_->getFUN()->getName(), " Scheduler::computeLookaheadSchedule()");
+
+    // the split chosen in this frame applies to the schedule of the next
+    numberOfTimeSlots_ = pendingNumberOfTimeSlots_;
+    computeSchedule(lookaheadSchedule_);
+    hasLookaheadSchedule_ = true;
+}
+
+void
+Scheduler::computeSchedule(FrameSchedule& frameSchedule)
 {
     accepting_ = true;
 
@@ -242,22 +334,59 @@ Scheduler::startScheduling()
         << "s = " << slotDuration * numberOfTimeSlots_ 
         << "s) to fit in data phase of duration " << getDuration() << "s");
 
+    int broadcastTimeSlots = 0;
+    if (schedulerSpot_ == wns::scheduler::SchedulerSpot::DLMaster())
+        broadcastTimeSlots = handleBroadcast(frameSchedule);
+
     /****************** Scheduling Phase ****************************************/
     // trigger the scheduling process of the strategy module
     wns::scheduler::strategy::StrategyInput strategyInput(freqChannels, 
         slotDuration, 
-        numberOfTimeSlots_, 
+        numberOfTimeSlots_ - broadcastTimeSlots, 
         maxBeams,
         NULL);
         //colleagues.callback);
 
     strategyInput.beamforming = beamforming;
 
-    strategyResult_ = wns::scheduler::strategy::StrategyResultPtr(
+    frameSchedule.strategyResult = wns::scheduler::strategy::StrategyResultPtr(
         new wns::scheduler::strategy::StrategyResult(colleagues.strategy->startScheduling(strategyInput))); 
 
-    // TODO: move to Scheduler::finishCollection() 
-    LOG_INFO(parent_->getFUN()->getName(), " Scheduler::finishCollection() in Scheduler::startScheduling(). numberOfTimeSlots_: ", numberOfTimeSlots_, " slotDuration: ", slotDuration);
+    LOG_INFO(parent_->getFUN()->getName(), " Scheduler::computeSchedule(). numberOfTimeSlots_: ", numberOfTimeSlots_, " slotDuration: ", slotDuration);
+    if (frameSchedule.strategyResult == wns::scheduler::strategy::StrategyResultPtr())
+    {
+           return;//empty map do nothing
+    }
+
+    collectBursts(frameSchedule);
+
+    // compounds are deleted from the master map before the UL-MAP is sent
+    if (schedulerSpot_ == wns::scheduler::SchedulerSpot::ULMaster())
+        frameSchedule.grants = GrantIndexPtr(new GrantIndex(frameSchedule.strategyResult->schedulingMap));
+}
+
+void
+Scheduler::applySchedule(const FrameSchedule& frameSchedule)
+{
+    strategyResult_ = frameSchedule.strategyResult;
+    bursts_ = frameSchedule.bursts;
+    grantIndex_ = frameSchedule.grants;
+
+    const BroadcastAllocation& broadcast = frameSchedule.broadcast;
+    if (broadcast.compound != wns::ldk::CompoundPtr())
+    {
+        DLCallback* callback = dynamic_cast<DLCallback*>(colleagues.callback);
+        assure(callback, "Broadcasts can only be scheduled by the DLCallback");
+
+        callback->scheduleBroadcast(broadcast.compound,
+                                    broadcast.timeSlot,
+                                    broadcast.numberOfTimeSlots,
+                                    slotDuration,
+                                    broadcast.startTime,
+                                    broadcast.endTime,
+                                    broadcast.phyMode);
+    }
+
     if (strategyResult_ == wns::scheduler::strategy::StrategyResultPtr())
     {
            return;//empty map do nothing
@@ -279,6 +408,44 @@ Scheduler::startScheduling()
     }
 }
 
+void
+Scheduler::scheduleGainedTimeSlots(int timeSlots)
+{
+    assure(schedulerSpot_ == wns::scheduler::SchedulerSpot::DLMaster(),
+           "Only the DL master schedules gained time slots");
+
+    if (timeSlots <= 0)
+        return;
+
+    DLCallback* callback = dynamic_cast<DLCallback*>(colleagues.callback);
+    assure(callback, "Gained time slots can only be scheduled by the DLCallback");
+
+    wns::scheduler::strategy::StrategyInput strategyInput(freqChannels,
+        slotDuration,
+        timeSlots,
+        maxBeams,
+        NULL);
+
+    strategyInput.beamforming = beamforming;
+
+    FrameSchedule frameSchedule;
+    frameSchedule.strategyResult = wns::scheduler::strategy::StrategyResultPtr(
+        new wns::scheduler::strategy::StrategyResult(colleagues.strategy->startScheduling(strategyInput)));
+
+    LOG_INFO(parent_->getFUN()->getName(), " Scheduler::scheduleGainedTimeSlots(): ",
+             timeSlots, " time slots behind ", numberOfTimeSlots_ + gainedTimeSlots_);
+
+    collectBursts(frameSchedule);
+    bursts_.insert(bursts_.end(), frameSchedule.bursts.begin(), frameSchedule.bursts.end());
+
+    // the gained slots follow the slots already scheduled in this frame
+    callback->setTimeSlotOffset(numberOfTimeSlots_ + gainedTimeSlots_);
+    callback->callBack(frameSchedule.strategyResult->schedulingMap);
+    callback->setTimeSlotOffset(0);
+
+    gainedTimeSlots_ += timeSlots;
+}
+
 void
 Scheduler::finishCollection() 
 { 
@@ -322,10 +489,10 @@ void Scheduler::setFUN(wns::ldk::fun::FUN* fun)
 		<wns::ldk::ClassifierCommand> *>("classifier");
 	assure(friends_.classifier, "Could not get the Classifier from my FUN");
 
-	service::ConnectionManager* connectionManager = dynamic_cast<wimac::Component*>
+	friends_.connectionManager = dynamic_cast<wimac::Component*>
 		(parent_->getFUN()->getLayer())->getManagementService<service::ConnectionManager>("connectionManager");
 
-	startObserving(connectionManager);
+	startObserving(friends_.connectionManager);
 
 	colleagues.registry->setFriends(friends_.classifier);
 
@@ -345,6 +512,21 @@ void Scheduler::setFUN(wns::ldk::fun::FUN* fun)
     colleagues.queue->setFUN(fun);
     colleagues.queue->setColleagues(colleagues.registry);
 
+    if (!pyConfig.isNone("broadcastQueue"))
+    {
+        wns::pyconfig::View broadcastQueueView = pyConfig.get<wns::pyconfig::View>("broadcastQueue");
+        wns::scheduler::queue::QueueCreator* broadcastQueueCreator =
+            wns::scheduler::queue::QueueFactory::creator(
+                broadcastQueueView.get<std::string>("nameInQueueFactory"));
+        colleagues.broadcastQueue = broadcastQueueCreator->create( parent_, broadcastQueueView );
+        assure(colleagues.broadcastQueue, "Broadcast queue creation failed");
+        assure(colleagues.broadcastQueue->supportsDynamicSegmentation(),
+               "The broadcast queue must segment, broadcasts are sent as one compound");
+
+        colleagues.broadcastQueue->setFUN(fun);
+        colleagues.broadcastQueue->setColleagues(colleagues.registry);
+    }
+
 	wns::scheduler::strategy::StrategyCreator* strategyCreator =
 		wns::scheduler::strategy::StrategyFactory::creator(strategyName);
 	colleagues.strategy = strategyCreator->create(pyConfig.get<wns::pyconfig::View>("strategy"));
@@ -416,84 +598,163 @@ Scheduler::getSchedulingMap() const {
 
 int
 Scheduler::getNumBursts() const {
-    assure(strategyResult_, "Strategy module not present");
-    int numOfSlots = 5;
-    return strategyResult_->schedulingMap->getNumberOfSubChannels() * numOfSlots;
+    return bursts_.size();
 }
 
 void
-Scheduler::handleBroadcast()
+Scheduler::collectBursts(FrameSchedule& frameSchedule)
 {
-/// @todo enable the broadcast again
+    wns::scheduler::SchedulingMapPtr schedulingMap = frameSchedule.strategyResult->schedulingMap;
 
-//	bool frameFull = false;
+    for(wns::scheduler::SubChannelVector::iterator iterSubChannel = schedulingMap->subChannels.begin();
+        iterSubChannel != schedulingMap->subChannels.end(); ++iterSubChannel)
+    {
+        // user of the previous time slot per beam, invalid if it was empty
+        std::vector<wns::scheduler::UserID> previous(maxBeams);
 
-// 	// do we have a broadcast queue with backlogged pdus?
-// 	if (colleagues.queue->hasQueue(0))
-// 	{
-// 		if (colleagues.queue->queueHasPDUs(0))
-// 		{
-// 			do {
-// 				const wns::service::phy::phymode::PhyModeInterface& phyMode
-// 					= colleagues.registry->getPhyModeMapper()->getLowestPhyMode();
+        for(wns::scheduler::SchedulingTimeSlotPtrVector::iterator iterTimeSlot =
+                iterSubChannel->temporalResources.begin();
+            iterTimeSlot != iterSubChannel->temporalResources.end(); ++iterTimeSlot)
+        {
+            wns::scheduler::PhysicalResourceBlockVector& prbs = (*iterTimeSlot)->physicalResources;
 
-// 				double dataRate =
-// 					//PHYTools::getBitsPerSymbol( PHYTools::BPSK12 ) * 1.0 / this->getFrameBuilder()->getSymbolDuration();
-// 					//phyMode.getBitsPerSymbol() / this->getFrameBuilder()->getSymbolDuration();
-// 					phyMode.getDataRate();
+            if (previous.size() < prbs.size())
+                previous.resize(prbs.size());
 
-//				wns::scheduler::Bits size = colleagues.queue->getHeadOfLinePDUbits(0);
+            for (std::size_t beam = 0; beam < prbs.size(); ++beam)
+            {
+                if (!prbs[beam].hasScheduledCompounds())
+                {
+                    previous[beam] = wns::scheduler::UserID();
+                    continue;
+                }
+
+                const wns::scheduler::SchedulingCompound& compound =
+                    *prbs[beam].scheduledCompoundsBegin();
+
+                if (!previous[beam].isValid() || !(previous[beam] == compound.userID))
+                {
+                    Burst burst;
+                    burst.user = compound.userID;
+                    burst.phyMode = compound.phyModePtr;
+                    frameSchedule.bursts.push_back(burst);
+                }
+                previous[beam] = compound.userID;
+            }
+        }
+    }
+}
 
-//				simTimeType duration = (double(size) / dataRate);
+int
+Scheduler::handleBroadcast(FrameSchedule& frameSchedule)
+{
+    const ConnectionIdentifier::CID cid = ConnectionIdentifier::BroadcastCID;
 
+    if (colleagues.broadcastQueue == NULL
+        || !colleagues.broadcastQueue->queueHasPDUs(cid))
+        return 0;
 
-//				if (duration  < (this->getMaximumDuration() - usedSlotDuration))
-//				{
+    wns::service::phy::phymode::PhyModeInterfacePtr phyModePtr =
+        colleagues.registry->getPhyModeMapper()->getLowestPhyMode();
+    double dataRate = phyModePtr->getDataRate();
 
-//					// if the broadcast fits, get the pdu and set the relevant
-//					// commands
+    // capacity of one subchannel in one time slot
+    Bit resourceBits = Bit(dataRate * slotDuration);
+    Bit queuedBits = colleagues.broadcastQueue->numBitsForCid(cid);
 
-//					wns::ldk::CompoundPtr pdu = colleagues.queue->getHeadOfLinePDU(0);
+    int broadcastTimeSlots = (queuedBits + resourceBits * freqChannels - 1)
+        / (resourceBits * freqChannels);
+    broadcastTimeSlots = std::min(broadcastTimeSlots, maxBroadcastTimeSlots_);
+    broadcastTimeSlots = std::min(broadcastTimeSlots, numberOfTimeSlots_);
 
-//					BroadcastPhyAccessFunc* func = new BroadcastPhyAccessFunc;
-//					func->transmissionStart_ = usedSlotDuration;
-//					func->transmissionStop_ =  usedSlotDuration + duration;
+    if (broadcastTimeSlots <= 0)
+        return 0;
 
+    int firstTimeSlot = numberOfTimeSlots_ - broadcastTimeSlots;
 
-//					// set PhyUser command
-//					wimac::PhyUserCommand* phyCommand = dynamic_cast<wimac::PhyUserCommand*>(
-//						parent_->getFUN()->getProxy()->activateCommand( pdu->getCommandPool(), friends_.phyUser ) );
+    // the queue concatenates the backlog into one segment filling the region
+    Bit capacity = resourceBits * freqChannels * broadcastTimeSlots;
+    wns::ldk::CompoundPtr pdu =
+        colleagues.broadcastQueue->getHeadOfLinePDUSegment(cid, capacity);
 
-// 					phyCommand->local.pAFunc_.reset( func );
+    BroadcastAllocation& allocation = frameSchedule.broadcast;
+    allocation.compound = pdu;
+    allocation.timeSlot = firstTimeSlot;
+    allocation.numberOfTimeSlots = broadcastTimeSlots;
+    allocation.startTime = firstTimeSlot * slotDuration;
+    allocation.endTime = allocation.startTime
+        + pdu->getLengthInBits() / (dataRate * freqChannels);
+    allocation.phyMode = phyModePtr;
 
-// 					phyCommand->peer.destination_ = 0;
-// 					wimac::Component* wimacLayer = dynamic_cast<wimac::Component*>(parent_->getFUN()->getLayer());
-// 					phyCommand->peer.cellID_ = wimacLayer->getCellID();
-// 					phyCommand->peer.source_ = wimacLayer->getNode();
-// 					//phyCommand->peer.phyMode_ = wimac::PHYTools::BPSK12;
-// 					//phyCommand->peer.phyMode_ = colleagues.registry->getPhyModeMapper()->getLowestPhyMode(); // TODO
-// 					phyCommand->peer.phyModePtr = &colleagues.registry->getPhyModeMapper()->getLowestPhyMode(); // TODO
-// 					phyCommand->peer.measureInterference_ = false;
-// 					phyCommand->magic.sourceLayer2_ = wimacLayer;
+    // all broadcasts are announced by one IE
+    Burst burst;
+    burst.phyMode = phyModePtr;
+    frameSchedule.bursts.push_back(burst);
 
-// 					if (plotFrames)
-// 						*plotFiles[0] << usedSlotDuration << "\t" <<  usedSlotDuration + duration << "\t"
-// 										  << float(0) << "\t" << 0.999 << "\t\"" << "BC" << "\"\n";
+    LOG_INFO(parent_->getFUN()->getName(), " Scheduler::handleBroadcast(): scheduled ",
+             pdu->getLengthInBits(), " broadcast bits in ", broadcastTimeSlots, " time slots");
 
+    return broadcastTimeSlots;
+}
 
-// 					this->pduWatch(pdu);  // Watch for special compounds to inform its observer
-// 					scheduledPDUs.push(pdu);
+void
+Scheduler::setNumberOfTimeSlots(int numberOfTimeSlots)
+{
+    assure(numberOfTimeSlots >= 0, "Negative number of time slots");
+
+    pendingNumberOfTimeSlots_ = numberOfTimeSlots;
+
+    // the schedule of the next frame has not been computed yet
+    if (!lookahead_ || schedulerSpot_ == wns::scheduler::SchedulerSpot::ULSlave())
+        numberOfTimeSlots_ = numberOfTimeSlots;
+}
+
+Bit
+Scheduler::getBacklog() const
+{
+    Bit backlog = 0;
 
-// 					MESSAGE_SINGLE(NORMAL, logger, "Scheduled a broadcast PDU");
+    wns::scheduler::ConnectionSet cids = colleagues.queue->getActiveConnections();
+    for (wns::scheduler::ConnectionSet::const_iterator it = cids.begin(); it != cids.end(); ++it)
+        backlog += colleagues.queue->numBitsForCid(*it);
 
-// 					usedSlotDuration += duration;
-// 				}
-// 				else
-// 					frameFull = true;
+    if (colleagues.broadcastQueue
+        && colleagues.broadcastQueue->queueHasPDUs(ConnectionIdentifier::BroadcastCID))
+        backlog += colleagues.broadcastQueue->numBitsForCid(ConnectionIdentifier::BroadcastCID);
 
-// 			} while (colleagues.queue->queueHasPDUs(0) && !frameFull);
-// 		}
-// 	}
+    return backlog;
+}
+
+bool
+Scheduler::hasPendingWork() const
+{
+    if (!bursts_.empty())
+        return true;
+
+    if (hasLookaheadSchedule_ && !lookaheadSchedule_.bursts.empty())
+        return true;
+
+    // retransmissions are not in the queues, they need frames as well
+    if (!colleagues.harq->getUsersWithRetransmissions().empty()
+        || !colleagues.harq->getPeersWithPendingRetransmissions().empty())
+        return true;
+
+    return getBacklog() > 0;
+}
+
+bool
+Scheduler::hasScheduledBurstsFor(const wns::node::Interface* node) const
+{
+    Bursts bursts = bursts_;
+    if (hasLookaheadSchedule_)
+        bursts.insert(bursts.end(), lookaheadSchedule_.bursts.begin(), lookaheadSchedule_.bursts.end());
+
+    for (Bursts::const_iterator it = bursts.begin(); it != bursts.end(); ++it)
+    {
+        if (it->user.isValid() && it->user.getNode() == node)
+            return true;
+    }
+    return false;
 }
 
 void
@@ -29,6 +29,7 @@
 
 #include <string>
 #include <queue>
+#include <vector>
 
 #include <WNS/Cloneable.hpp>
 #include <WNS/pyconfig/View.hpp>
@@ -37,9 +38,12 @@
 #include <WNS/Observer.hpp>
 #include <WNS/probe/bus/ContextCollector.hpp>
 #include <WNS/scheduler/strategy/StrategyInterface.hpp>
+#include <WNS/service/phy/phymode/PhyModeInterface.hpp>
+#include <WNS/simulator/Bit.hpp>
 
 #include <WIMAC/Classifier.hpp>
 #include <WIMAC/Logger.hpp>
+#include <WIMAC/scheduler/GrantIndex.hpp>
 #include <WIMAC/scheduler/Interface.hpp>
 #include <WIMAC/services/ConnectionManager.hpp>
 
@@ -100,6 +104,48 @@ namespace wimac { namespace scheduler {
             public wns::Observer<wimac::service::ConnectionDeletedNotification>
         {
         public:
+            /**
+             * @brief A burst is announced by one IE of the MAP.
+             *
+             * Consecutive time slots of one user on the same subchannel and
+             * beam form one burst.
+             */
+            struct Burst
+            {
+                wns::scheduler::UserID user;
+                wns::service::phy::phymode::PhyModeInterfacePtr phyMode;
+            };
+            typedef std::vector<Burst> Bursts;
+
+            /**
+             * @brief The broadcast transmission placed by handleBroadcast.
+             *
+             * The backlog of the broadcast queue is sent as one compound
+             * over the whole broadcast region, compound is empty if there
+             * is nothing to broadcast.
+             */
+            struct BroadcastAllocation
+            {
+                wns::ldk::CompoundPtr compound;
+                int timeSlot;
+                int numberOfTimeSlots;
+                simTimeType startTime;
+                simTimeType endTime;
+                wns::service::phy::phymode::PhyModeInterfacePtr phyMode;
+            };
+
+            /**
+             * @brief Everything decided for one frame.
+             */
+            struct FrameSchedule
+            {
+                wns::scheduler::strategy::StrategyResultPtr strategyResult;
+                Bursts bursts;
+                BroadcastAllocation broadcast;
+                /** @brief Only built by the UL master */
+                GrantIndexPtr grants;
+            };
+
             Scheduler(wns::ldk::FunctionalUnit* parent, const wns::pyconfig::View& config);
 
             ~Scheduler();
@@ -138,6 +184,25 @@ namespace wimac { namespace scheduler {
             }
             int getNumBursts() const;
 
+            /**
+             * @brief Grants of the current schedule by user, only
+             * available at the UL master.
+             */
+            GrantIndexPtr
+            getGrantIndex() const
+            {
+                return grantIndex_;
+            }
+
+            /**
+             * @brief The bursts of the last schedule, including broadcasts.
+             */
+            const Bursts&
+            getBursts() const
+            {
+                return bursts_;
+            }
+
             void notifyAboutConnectionDeleted(const ConnectionIdentifier);
 
             /**
@@ -152,9 +217,141 @@ namespace wimac { namespace scheduler {
             wns::scheduler::harq::HARQInterface*
             getHARQ(){return colleagues.harq;};
 
+            /**
+             * @brief Number of time slots available for the next schedule.
+             *
+             * Changed per frame by the adaptive TDD split, which keeps the
+             * phase duration consistent. In lookahead mode the schedule of
+             * the next frame has already been computed, so the value takes
+             * effect with the following lookahead schedule.
+             */
+            void
+            setNumberOfTimeSlots(int numberOfTimeSlots);
+
+            /**
+             * @brief Time slots of the schedule applied in the current
+             * frame (or computed next, if none is pending).
+             */
+            int
+            getNumberOfTimeSlots() const
+            {
+                return numberOfTimeSlots_;
+            }
+
+            int
+            getConfiguredNumberOfTimeSlots() const
+            {
+                return configuredNumberOfTimeSlots_;
+            }
+
+            /**
+             * @brief Schedule timeSlots more time slots behind the current
+             * schedule of the DL master.
+             *
+             * Used when the MAPs leave time to the DL data phase. The
+             * bursts of these slots are added to getBursts(), so they have
+             * to be scheduled before the DL-MAP is built.
+             */
+            void
+            scheduleGainedTimeSlots(int timeSlots);
+
+            /**
+             * @brief Time slots added to the current schedule by
+             * scheduleGainedTimeSlots.
+             */
+            int
+            getGainedTimeSlots() const
+            {
+                return gainedTimeSlots_;
+            }
+
+            unsigned int
+            getNumberOfSubChannels() const
+            {
+                return freqChannels;
+            }
+
+            unsigned int
+            getMaxBeams() const
+            {
+                return maxBeams;
+            }
+
+            double
+            getSlotDuration() const
+            {
+                return slotDuration;
+            }
+
+            /**
+             * @brief Bits waiting in the queues of this scheduler.
+             */
+            Bit
+            getBacklog() const;
+
+            /**
+             * @brief True if data is queued, HARQ has retransmissions
+             * pending or the last or a precomputed schedule carries bursts.
+             *
+             * A frame without bursts has to pass before the scheduler
+             * counts as idle, so feedback on the last transmissions
+             * still gets a frame.
+             */
+            bool
+            hasPendingWork() const;
+
+            /**
+             * @brief True if the schedule of the current frame or the
+             * precomputed one of the next frame holds bursts for node.
+             *
+             * Such a station must not go to sleep, these schedules are
+             * sent no matter what.
+             */
+            bool
+            hasScheduledBurstsFor(const wns::node::Interface* node) const;
+
         protected:
             void setupPlotting();
-            void handleBroadcast();
+
+            /**
+             * @brief Append the bursts of the strategy result to the bursts
+             * of frameSchedule.
+             *
+             * Must be called before the callback clears the scheduled
+             * compounds.
+             */
+            void collectBursts(FrameSchedule& frameSchedule);
+
+            /**
+             * @brief Run the strategy and fill frameSchedule.
+             */
+            void computeSchedule(FrameSchedule& frameSchedule);
+
+            /**
+             * @brief Make frameSchedule the current schedule and hand it to
+             * the callback.
+             */
+            void applySchedule(const FrameSchedule& frameSchedule);
+
+            /**
+             * @brief Compute the schedule of the next frame in lookahead
+             * mode.
+             */
+            void computeLookaheadSchedule();
+
+            /**
+             * @brief Reserve the last time slots of the frame for the
+             * backlog of the broadcast queue.
+             *
+             * The backlog is segmented into one compound that is sent
+             * omnidirectionally with the lowest PhyMode over all
+             * subchannels of the reserved slots. At most
+             * maxBroadcastTimeSlots_ time slots are used, the remaining
+             * slots are left to the strategy.
+             *
+             * @return The number of time slots used for broadcasts
+             */
+            int handleBroadcast(FrameSchedule& frameSchedule);
 
             bool plotFrames;
 
@@ -168,6 +365,8 @@ namespace wimac { namespace scheduler {
                 wimac::scheduler::RegistryProxyWiMAC* registry;
                 wimac::scheduler::Callback* callback;
                 wimac::scheduler::PseudoBWRequestGenerator* pseudoGenerator;
+                // optional, holds compounds on the BroadcastCID
+                wns::scheduler::queue::QueueInterface* broadcastQueue;
             } colleagues;
 
             wns::simulator::Time usedSlotDuration;
@@ -176,6 +375,8 @@ namespace wimac { namespace scheduler {
             unsigned int maxBeams;
             bool beamforming;
             int numberOfTimeSlots_;
+            int configuredNumberOfTimeSlots_;
+            int gainedTimeSlots_;
             bool uplink;
 	    bool alwaysAcceptIfQueueAccepts;
 
@@ -183,6 +384,7 @@ namespace wimac { namespace scheduler {
             {
                 wns::ldk::CommandTypeSpecifier<wns::ldk::ClassifierCommand>* classifier;
                 wimac::PhyUser* phyUser;
+                service::ConnectionManager* connectionManager;
             } friends_;
 
             wns::logger::Logger logger;
@@ -190,6 +392,8 @@ namespace wimac { namespace scheduler {
 
         private:
             bool doIsAccepting(const wns::ldk::CompoundPtr& compound) const;
+
+            bool isBroadcast(const wns::ldk::CompoundPtr& compound) const;
             void doStart(int);
 
             void putProbe(int bits, int compounds);
@@ -200,6 +404,7 @@ namespace wimac { namespace scheduler {
             std::string queueName;
             std::string registryName;
             std::string callbackName;
+            int maxBroadcastTimeSlots_;
             wns::simulator::Time duration_;
 
             wimac::frame::MapHandlerInterface* mapHandler_;
@@ -220,6 +425,21 @@ namespace wimac { namespace scheduler {
             wns::probe::bus::ContextCollectorPtr resetedCompoundsProbe;
 
             wns::scheduler::strategy::StrategyResultPtr strategyResult_;
+            Bursts bursts_;
+            GrantIndexPtr grantIndex_;
+
+            /**
+             * @brief Compute the schedule of frame n+1 during frame n.
+             *
+             * The schedule is computed lookaheadDelay_ after the start of
+             * scheduling in frame n and used in frame n+1.
+             */
+            bool lookahead_;
+            wns::simulator::Time lookaheadDelay_;
+            FrameSchedule lookaheadSchedule_;
+            /** @brief Set by setNumberOfTimeSlots for the next lookahead schedule */
+            int pendingNumberOfTimeSlots_;
+            bool hasLookaheadSchedule_;
 
             wns::ldk::FunctionalUnit* parent_;
             wns::ldk::Receptor* receptor_;
@@ -85,15 +85,25 @@ ULCallback::callBack(wns::scheduler::SchedulingMapPtr schedulingMap)
                 if ( iterPRB->hasScheduledCompounds() )
                 {
                     wns::scheduler::ScheduledCompoundsList::const_iterator it;
-                    
+
+                    /* Put estimated CQI in*/
                     for(it = iterPRB->scheduledCompoundsBegin();
                         it != iterPRB->scheduledCompoundsEnd();
                         it++)
-                    { // for every compound in subchannel:
-                        /* Put estimated CQI in*/
                         it->estimatedCQI = iterPRB->getEstimatedCQI();
+
+                    // HARQ handles the resource as one transport block, no
+                    // matter how many compounds it carries. Stored first, so
+                    // the copies in the compounds carry the HARQ state.
+                    colleagues.harq->storeSchedulingTimeSlot(tbCounter_, timeSlotPtr);
+
+                    for(it = iterPRB->scheduledCompoundsBegin();
+                        it != iterPRB->scheduledCompoundsEnd();
+                        it++)
+                    { // for every compound in subchannel:
                         processPacket(*it, timeSlotPtr);
                     } // for (all scheduledCompounds)
+
                     iterPRB->clearScheduledCompounds();
                 } // if there were compounds in this resource
             } // forall beams
@@ -193,8 +203,6 @@ ULCallback::processPacket(const wns::scheduler::SchedulingCompound & compound,
     phyCommand->peer.measureInterference_ = true; // measureInterference;
     phyCommand->peer.estimatedCQI = estimatedCQI;
     phyCommand->magic.sourceComponent_ = wimacComponent;
-    colleagues.harq->storeSchedulingTimeSlot(tbCounter_, timeSlotPtr);
-
     phyCommand->magic.schedulingTimeSlot = wns::scheduler::SchedulingTimeSlotPtr(
         new wns::scheduler::SchedulingTimeSlot(*timeSlotPtr));
   
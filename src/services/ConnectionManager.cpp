@@ -61,6 +61,7 @@ ConnectionManager::ConnectionManager( wns::ldk::ManagementServiceRegistry* msr,
     ManagementService( msr ),
     connectionIdentifiers_(),
     highestCID_( 1 ),
+    changing_( false ),
     config_( config )
 {
     layer_ = dynamic_cast<Component*>(msr->getLayer());
@@ -70,11 +71,15 @@ ConnectionManager::ConnectionManager( wns::ldk::ManagementServiceRegistry* msr,
 ConnectionManager::ConnectionManager( const ConnectionManager& other ) :
     wns::ldk::ManagementServiceInterface( other ),
     Subject::SubjectType( other ),
+    AddedSubject::SubjectType( other ),
     ConnectionManagerInterface(),
     wns::ldk::ManagementService( other ),
     Subject( other ),
+    AddedSubject( other ),
     connectionIdentifiers_( other.connectionIdentifiers_ ),
     highestCID_( other.highestCID_ ),
+    notListening_( other.notListening_ ),
+    changing_( false ),
     layer_( other.layer_ ),
     config_( other.config_ )
 {}
@@ -123,6 +128,9 @@ ConnectionManager::appendConnection( const ConnectionIdentifier& connection )
     LOG_INFO( getMSR()->getLayer()->getName() , ": Register",
               *connectionPtr );
 
+    wns::Subject<ConnectionAddedNotification>::sendNotifies
+        (&ConnectionAddedNotification::notifyAboutConnectionAdded, *connectionPtr);
+
     return ConnectionIdentifier(*connectionPtr);
 }
 
@@ -244,10 +252,20 @@ ConnectionManager::changeConnection( const ConnectionIdentifier& connection )
                 << **it;
             LOG_INFO( log.str() );
 
+            // observers keep their own tables, present the change as
+            // deletion of the old and addition of the new CI
+            changing_ = true;
+            wns::Subject<ConnectionDeletedNotification>::sendNotifies
+                (&ConnectionDeletedNotification::notifyAboutConnectionDeleted, **it);
+
             ConnectionIdentifierPtr connectionPtr(
                 new ConnectionIdentifier( connection ) );
             connectionIdentifiers_.insert( it, connectionPtr);
             connectionIdentifiers_.erase( it++ );
+
+            wns::Subject<ConnectionAddedNotification>::sendNotifies
+                (&ConnectionAddedNotification::notifyAboutConnectionAdded, *connectionPtr);
+            changing_ = false;
             return;
         } else
             ++it;
@@ -277,10 +295,18 @@ ConnectionManager::changeConnections( ConnectionIdentifiers& connections )
             if ( **it1 == **it2 )
             {
                 ciFound = true;
+                changing_ = true;
+                wns::Subject<ConnectionDeletedNotification>::sendNotifies
+                    (&ConnectionDeletedNotification::notifyAboutConnectionDeleted, **it2);
+
                 ConnectionIdentifierPtr connectionPtr(
                     new ConnectionIdentifier(*(*it1)));
                 connectionIdentifiers_.insert( it2, connectionPtr);
                 connectionIdentifiers_.erase( it2++ );
+
+                wns::Subject<ConnectionAddedNotification>::sendNotifies
+                    (&ConnectionAddedNotification::notifyAboutConnectionAdded, *connectionPtr);
+                changing_ = false;
                 break;
             } else
                 ++it2;
@@ -806,10 +832,39 @@ ConnectionManager::decreaseCINotListening()
             LOG_INFO( log.str() );
 
             ((*it)->ciNotListening_)--;
+
+            if ( (*it)->ciNotListening_ == 0 )
+                notListening_.erase( (*it)->subscriberStation_ );
         }
     }
 }
 
+void
+ConnectionManager::setNotListening( StationID subscriberStation, ConnectionIdentifier::Frames frames )
+{
+    assure( frames >= 0, "Negative number of frames not listening" );
+
+    getBasicConnectionFor( subscriberStation )->ciNotListening_ = frames;
+
+    if ( frames > 0 )
+        notListening_.insert( subscriberStation );
+    else
+        notListening_.erase( subscriberStation );
+}
+
+bool
+ConnectionManager::isListening( ConnectionIdentifier::CID cid ) const
+{
+    if ( notListening_.empty() )
+        return true;
+
+    ConnectionIdentifierPtr ci = getConnectionWithID( cid );
+    if ( !ci )
+        return true;
+
+    return notListening_.find( ci->subscriberStation_ ) == notListening_.end();
+}
+
 
 
 ConnectionIdentifierPtr
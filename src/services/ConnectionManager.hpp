@@ -33,6 +33,7 @@
 
 #include <WNS/ldk/ldk.hpp>
 #include <list>
+#include <set>
 #include <WNS/Cloneable.hpp>
 #include <WNS/SmartPtr.hpp>
 #include <WNS/ldk/ManagementServiceInterface.hpp>
@@ -95,6 +96,12 @@ namespace wimac {
             virtual ~ConnectionDeletedNotification(){}
         };
 
+        class ConnectionAddedNotification {
+        public:
+            virtual void notifyAboutConnectionAdded( const ConnectionIdentifier ) = 0;
+            virtual ~ConnectionAddedNotification(){}
+        };
+
         /**
          * @brief Manager to manage connections.
          *
@@ -110,10 +117,12 @@ namespace wimac {
         class ConnectionManager :
             public ConnectionManagerInterface,
             public wns::ldk::ManagementService,
-            public wns::Subject<ConnectionDeletedNotification>
+            public wns::Subject<ConnectionDeletedNotification>,
+            public wns::Subject<ConnectionAddedNotification>
         {
 
             typedef wns::Subject<ConnectionDeletedNotification> Subject;
+            typedef wns::Subject<ConnectionAddedNotification> AddedSubject;
         public:
 
             ConnectionManager( wns::ldk::ManagementServiceRegistry* msr,
@@ -321,6 +330,40 @@ namespace wimac {
             void
             decreaseCINotListening();
 
+            /**
+             * @brief Set the number of frames the subscriber station does
+             * not listen, 0 if it listens.
+             */
+            void
+            setNotListening(StationID subscriberStation, ConnectionIdentifier::Frames frames);
+
+            /**
+             * @brief False if the subscriber station of the connection
+             * does not listen.
+             */
+            bool
+            isListening(ConnectionIdentifier::CID cid) const;
+
+            bool
+            allListening() const
+            {
+                return notListening_.empty();
+            }
+
+            /**
+             * @brief True while a change of a connection is announced.
+             *
+             * changeConnection() notifies the deletion of the old and the
+             * addition of the new ConnectionIdentifier. Observers keeping
+             * data of the connection, like queued compounds, ignore the
+             * deletion in this case.
+             */
+            bool
+            isChanging() const
+            {
+                return changing_;
+            }
+
             void onMSRCreated();
 
             ConnectionIdentifier::CID getAndIncreaseHighestCellCID();
@@ -342,6 +385,14 @@ namespace wimac {
 
             ConnectionIdentifier::CID highestCID_;
 
+            /**
+             * @brief Subscriber stations whose basic connection is not
+             * listening.
+             */
+            std::set<StationID> notListening_;
+
+            bool changing_;
+
             /**
              * @brief Station this ConnectionManager belongs to.
              */
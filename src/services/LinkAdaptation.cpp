@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/services/LinkAdaptation.hpp>
+#include <WIMAC/Logger.hpp>
+
+#include <algorithm>
+
+STATIC_FACTORY_REGISTER_WITH_CREATOR(
+    wimac::service::LinkAdaptation,
+    wns::ldk::ManagementServiceInterface,
+    "wimac.services.LinkAdaptation",
+    wns::ldk::MSRConfigCreator);
+
+using namespace wimac::service;
+
+LinkAdaptation::LinkAdaptation(wns::ldk::ManagementServiceRegistry* msr,
+                               const wns::pyconfig::View& config) :
+    wns::ldk::ManagementService(msr),
+    offsets_(),
+    targetBLER_(config.get<double>("targetBLER")),
+    stepDown_(config.get<double>("stepDown")),
+    minOffset_(config.get<double>("minOffset")),
+    maxOffset_(config.get<double>("maxOffset"))
+{
+    assure(targetBLER_ > 0.0 && targetBLER_ < 1.0, "targetBLER must be in (0, 1)");
+    assure(minOffset_ <= 0.0 && maxOffset_ >= 0.0, "The offset range must include 0 dB");
+}
+
+void
+LinkAdaptation::storeOutcome(wns::node::Interface* peer, Direction direction, double blockError)
+{
+    assure(blockError >= 0.0 && blockError <= 1.0, "Block error must be a probability");
+
+    double& offset = offsets_[Link(peer, direction)];
+
+    // Expected OLLA step for a success with probability 1 - blockError
+    offset += stepDown_ * (targetBLER_ - blockError) / (1.0 - targetBLER_);
+    offset = std::max(minOffset_, std::min(maxOffset_, offset));
+}
+
+wns::Ratio
+LinkAdaptation::getOffset(wns::node::Interface* peer, Direction direction) const
+{
+    OffsetMap::const_iterator it = offsets_.find(Link(peer, direction));
+
+    if (it == offsets_.end())
+        return wns::Ratio::from_dB(0.0);
+
+    return wns::Ratio::from_dB(it->second);
+}
+
+wns::scheduler::ChannelQualityOnOneSubChannel
+LinkAdaptation::correct(wns::node::Interface* peer,
+                        Direction direction,
+                        const wns::scheduler::ChannelQualityOnOneSubChannel& estimate) const
+{
+    double offset = getOffset(peer, direction).get_dB();
+
+    if (offset == 0.0)
+        return estimate;
+
+    // Carrier and pathloss both enter SINR estimates of the strategies
+    return wns::scheduler::ChannelQualityOnOneSubChannel(
+        wns::Ratio::from_dB(estimate.pathloss.get_dB() - offset),
+        estimate.interference,
+        wns::Power::from_dBm(estimate.carrier.get_dBm() + offset));
+}
@@ -0,0 +1,103 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_SERVICES_LINKADAPTATION_HPP
+#define WIMAC_SERVICES_LINKADAPTATION_HPP
+
+#include <WNS/ldk/ldk.hpp>
+#include <WNS/ldk/ManagementServiceInterface.hpp>
+#include <WNS/node/Interface.hpp>
+#include <WNS/pyconfig/View.hpp>
+#include <WNS/PowerRatio.hpp>
+#include <WNS/scheduler/SchedulerTypes.hpp>
+
+#include <map>
+
+namespace wimac { namespace service {
+
+        /**
+         * @brief Outer loop link adaptation (OLLA).
+         *
+         * Keeps one SINR offset per link that corrects the bias of the
+         * channel quality estimates the PhyMode selection is based on.
+         * Each decoding outcome moves the offset towards the targetBLER: a
+         * failure lowers it by stepDown, a success raises it by
+         * stepDown * targetBLER / (1 - targetBLER).
+         *
+         * The receiver of a compound reports to its own service (Receive)
+         * and to the one of the sender (Transmit), so both sides of a link
+         * know the offset.
+         */
+        class LinkAdaptation :
+            public wns::ldk::ManagementService
+        {
+        public:
+            enum Direction {
+                Transmit,
+                Receive
+            };
+
+            LinkAdaptation(wns::ldk::ManagementServiceRegistry* msr,
+                           const wns::pyconfig::View& config);
+
+            virtual
+            ~LinkAdaptation() {}
+
+            /**
+             * @brief Report the outcome of one decoded compound.
+             *
+             * @param blockError Probability that the compound was not
+             * decoded. Hard outcomes are 0.0 and 1.0, the PER of the
+             * ErrorModelling is used as a soft outcome of the CRC.
+             */
+            void
+            storeOutcome(wns::node::Interface* peer, Direction direction, double blockError);
+
+            wns::Ratio
+            getOffset(wns::node::Interface* peer, Direction direction) const;
+
+            /**
+             * @brief Shift an estimate by the offset of the link
+             */
+            wns::scheduler::ChannelQualityOnOneSubChannel
+            correct(wns::node::Interface* peer,
+                    Direction direction,
+                    const wns::scheduler::ChannelQualityOnOneSubChannel& estimate) const;
+
+        private:
+            typedef std::pair<wns::node::Interface*, Direction> Link;
+            typedef std::map<Link, double> OffsetMap;
+
+            OffsetMap offsets_;
+
+            double targetBLER_;
+            double stepDown_;
+            double minOffset_;
+            double maxOffset_;
+        };
+    }
+}
+
+#endif // WIMAC_SERVICES_LINKADAPTATION_HPP
@@ -42,6 +42,8 @@ QueueManager::QueueManager(wns::ldk::ManagementServiceRegistry* msr,
     wns::scheduler::queue::IQueueManager(msr, config),
     connectionManagerServiceName_(config.get<std::string>("connectionManagerServiceName")),
     connectionManager_(NULL),
+    entries_(),
+    queues_(),
     logger_(config.get("logger"))
 {
     MESSAGE_BEGIN(NORMAL, logger_, m, "QueueManager");
@@ -62,6 +64,16 @@ QueueManager::onMSRCreated()
             connectionManagerServiceName_);
     assure(connectionManager_ != NULL, "QueueManager needs a ConnectionManager");
 
+    wns::Observer<ConnectionAddedNotification>::startObserving(connectionManager_);
+    wns::Observer<ConnectionDeletedNotification>::startObserving(connectionManager_);
+
+    // Connections registered before we started observing
+    ConnectionIdentifiers ci =
+        connectionManager_->getAllDataConnections(ConnectionIdentifier::Uplink);
+
+    for(ConnectionIdentifiers::iterator it = ci.begin(); it != ci.end(); ++it)
+        addConnection(**it);
+
     MESSAGE_BEGIN(NORMAL, logger_, m, "QueueManager");
     m << " Found valid ConnectionManagerService ";
     m << connectionManagerServiceName_;
@@ -69,134 +81,88 @@ QueueManager::onMSRCreated()
 
 }
 
-wns::scheduler::queue::QueueContainer
-QueueManager::getAllQueues()
+void
+QueueManager::notifyAboutConnectionAdded(const ConnectionIdentifier cid)
 {
-    wns::scheduler::queue::QueueContainer queues;
-
-    ConnectionIdentifiers ci;
-    ci = connectionManager_->getAllDataConnections(ConnectionIdentifier::Uplink);
-    if(ci.empty())
-        return queues;
-
-    ConnectionIdentifiers::iterator it;
-
-    for(it = ci.begin(); it != ci.end(); it++)
-    {
-        wns::scheduler::queue::QueueInterface* queue;
-
-        if(cache_.find((*it)->cid_) != cache_.end())
-        {
-            queue = cache_[(*it)->cid_];
-        }
-        else
-        {
-           queue = getQueue((*it)->subscriberStation_, (*it)->cid_);
-
-            if(queue != NULL)
-            {            
-                MESSAGE_BEGIN(NORMAL, logger_, m, "QueueManager");
-                m << " Storing Queue pointer for CID ";
-                m << (*it)->cid_ << " in cache";
-                MESSAGE_END();
-                cache_[(*it)->cid_] = queue;
-            }
-        }
-        if(queue != NULL)
-            queues[(*it)->cid_] = queue;                
-    }        
-    return queues;
+    if(cid.connectionType_ == ConnectionIdentifier::Data
+       && cid.direction_ == ConnectionIdentifier::Uplink)
+        addConnection(cid);
 }
 
-wns::scheduler::queue::QueueInterface*
-QueueManager::getQueue(wns::scheduler::ConnectionID cid)
+void
+QueueManager::notifyAboutConnectionDeleted(const ConnectionIdentifier cid)
 {
-    wns::scheduler::queue::QueueInterface* queue;
-    if(cache_.find(cid) != cache_.end())
-    {
-        queue = cache_[cid];
-    }
-    else
-    {
-        queue = getQueue(getStationID(cid), cid);
-                 
-        if(queue != NULL)
-        {
-            MESSAGE_BEGIN(NORMAL, logger_, m, "QueueManager");
-            m << " Storing Queue pointer for CID ";
-            m << cid << " in cache";
-            MESSAGE_END();
-            cache_[cid] = queue;
-        }
-    }
-    return queue;
+    QueueEntryMap::iterator it = entries_.find(cid.cid_);
+    if(it == entries_.end())
+        return;
+
+    MESSAGE_BEGIN(NORMAL, logger_, m, "QueueManager");
+    m << " Removing Queue for CID ";
+    m << cid.cid_;
+    MESSAGE_END();
+
+    entries_.erase(it);
+    queues_.erase(cid.cid_);
 }
 
 void
-QueueManager::startCollection(wns::scheduler::ConnectionID cid)
+QueueManager::addConnection(const ConnectionIdentifier& ci)
 {
-    wimac::frame::DataCollector* dc;
-
-    if(dcCache_.find(cid) != dcCache_.end())
-        dc = dcCache_[cid];
-    else
-    {
-        Component* peerComponent = dynamic_cast<wimac::Component*>(
-            TheStationManager::getInstance()->getStationByID(getStationID(cid)) );
-    
-        wns::ldk::fun::Main* fun = peerComponent->getFUN();
-        dc = fun->findFriend<wimac::frame::DataCollector*>("ulscheduler");
-        dcCache_[cid] = dc;
-    }
+    QueueEntry entry;
+    entry.stationID = ci.subscriberStation_;
+
+    Component* peerComponent = dynamic_cast<wimac::Component*>(
+        TheStationManager::getInstance()->getStationByID(entry.stationID) );
+    assure(peerComponent, "Invalid peer layer pointer");
+
+    entry.dataCollector =
+        peerComponent->getFUN()->findFriend<wimac::frame::DataCollector*>("ulscheduler");
+    assure(entry.dataCollector, "Cannot find DataCollector in FUN");
+
+    entry.queue = entry.dataCollector->getTxScheduler()->getQueue();
 
     MESSAGE_BEGIN(NORMAL, logger_, m, "QueueManager");
-    m << " Starting data collection for CID ";
-    m << cid;
+    m << " Storing Queue pointer for CID ";
+    m << ci.cid_ << " of station " << entry.stationID;
     MESSAGE_END();
 
-    assure(dc, "Cannot find DataCollector in FUN");
-    dc->getTxScheduler()->startScheduling();
+    entries_[ci.cid_] = entry;
+    if(entry.queue != NULL)
+        queues_[ci.cid_] = entry.queue;
+}
+
+wns::scheduler::queue::QueueContainer
+QueueManager::getAllQueues()
+{
+    return queues_;
+}
+
+const wns::scheduler::queue::QueueContainer&
+QueueManager::getQueues() const
+{
+    return queues_;
 }
 
 wns::scheduler::queue::QueueInterface*
-QueueManager::getQueue(ConnectionIdentifier::StationID peerStationId, wns::scheduler::ConnectionID cid)
+QueueManager::getQueue(wns::scheduler::ConnectionID cid)
 {
-    if(peerStationId == -1)
+    QueueEntryMap::const_iterator it = entries_.find(cid);
+    if(it == entries_.end())
         return NULL;
 
-    wimac::frame::DataCollector* dc;
-
-    if(dcCache_.find(cid) != dcCache_.end())
-        dc = dcCache_[cid];
-    else
-    {
-        Component* peerComponent = dynamic_cast<wimac::Component*>(
-            TheStationManager::getInstance()->getStationByID(peerStationId) );
-    
-        wns::ldk::fun::Main* fun = peerComponent->getFUN();
-        dc = fun->findFriend<wimac::frame::DataCollector*>("ulscheduler");
-        dcCache_[cid] = dc;
-    }
-
-    assure(dc, "Cannot find DataCollector in FUN");
-    return dc->getTxScheduler()->getQueue();
+    return it->second.queue;
 }
 
-wimac::ConnectionIdentifier::StationID
-QueueManager::getStationID(wns::scheduler::ConnectionID cid)
+void
+QueueManager::startCollection(wns::scheduler::ConnectionID cid)
 {
-    ConnectionIdentifiers ci;
-    ci = connectionManager_->getAllDataConnections(ConnectionIdentifier::Uplink);
-    assure(!ci.empty(), "Tried to get StationID from CID but no CIDs are known yet");
-
-    ConnectionIdentifiers::iterator it;
-
-    for(it = ci.begin(); it != ci.end(); it++)
-    {
-        if((*it)->cid_ == cid)
-            return (*it)->subscriberStation_;                
-    }
-    return -1;
-    //assure(false, "Cannot find StationID for CID");
-}
+    QueueEntryMap::const_iterator it = entries_.find(cid);
+    assure(it != entries_.end(), "QueueManager: No uplink data connection for this CID");
 
+    MESSAGE_BEGIN(NORMAL, logger_, m, "QueueManager");
+    m << " Starting data collection for CID ";
+    m << cid;
+    MESSAGE_END();
+
+    it->second.dataCollector->getTxScheduler()->startScheduling();
+}
@@ -33,19 +33,39 @@
 #include <WIMAC/ConnectionIdentifier.hpp>
 #include <WIMAC/frame/DataCollector.hpp>
 #include <WNS/logger/Logger.hpp>
+#include <WNS/Observer.hpp>
 
 namespace wimac { namespace service {
 
-            typedef std::map<wns::scheduler::ConnectionID, wns::scheduler::queue::QueueInterface*> CIDtoQueueMap;
-            typedef std::map<wns::scheduler::ConnectionID, wimac::frame::DataCollector*> CIDtoDCMap;
-
             /**
              * @brief System specific implementation to map CIDs to queues. Calls only return UL
              * slave queues.
-             */            
+             *
+             * The CID -> (StationID, DataCollector, queue) table is kept up to
+             * date by observing the ConnectionManager. Uplink data connections
+             * are added when they are registered and removed when they are
+             * deleted, so lookups never scan the connection list.
+             */
             class QueueManager:
-                public wns::scheduler::queue::IQueueManager
+                public wns::scheduler::queue::IQueueManager,
+                public wns::Observer<ConnectionAddedNotification>,
+                public wns::Observer<ConnectionDeletedNotification>
             {
+                struct QueueEntry
+                {
+                    QueueEntry() :
+                        stationID(-1),
+                        dataCollector(NULL),
+                        queue(NULL)
+                    {}
+
+                    wimac::ConnectionIdentifier::StationID stationID;
+                    wimac::frame::DataCollector* dataCollector;
+                    wns::scheduler::queue::QueueInterface* queue;
+                };
+
+                typedef std::map<wns::scheduler::ConnectionID, QueueEntry> QueueEntryMap;
+
             public:
                 QueueManager(wns::ldk::ManagementServiceRegistry* msr, const wns::pyconfig::View& config);
 
@@ -57,6 +77,14 @@ namespace wimac { namespace service {
                 virtual wns::scheduler::queue::QueueContainer
                 getAllQueues();
 
+                /**
+                 * @brief Return all managed queues without copying the
+                 * container. The reference stays valid for the lifetime of
+                 * the QueueManager.
+                 */
+                const wns::scheduler::queue::QueueContainer&
+                getQueues() const;
+
                 /**
                  * @brief Get queue for CID
                  */
@@ -72,17 +100,20 @@ namespace wimac { namespace service {
                 virtual void
                 onMSRCreated();
 
-            private:
-                wimac::ConnectionIdentifier::StationID
-                getStationID(wns::scheduler::ConnectionID cid);
+                virtual void
+                notifyAboutConnectionAdded(const ConnectionIdentifier cid);
 
-                wns::scheduler::queue::QueueInterface*
-                getQueue(wimac::ConnectionIdentifier::StationID peerStationId, wns::scheduler::ConnectionID cid);
+                virtual void
+                notifyAboutConnectionDeleted(const ConnectionIdentifier cid);
+
+            private:
+                void
+                addConnection(const ConnectionIdentifier& ci);
 
                 std::string connectionManagerServiceName_;
                 wimac::service::ConnectionManager* connectionManager_;
-                CIDtoQueueMap cache_;
-                CIDtoDCMap dcCache_;
+                QueueEntryMap entries_;
+                wns::scheduler::queue::QueueContainer queues_;
                 wns::logger::Logger logger_;
             };
         }} // namespace wimac::service
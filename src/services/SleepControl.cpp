@@ -0,0 +1,255 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/services/SleepControl.hpp>
+
+#include <WNS/ldk/fcf/FrameBuilder.hpp>
+
+#include <WIMAC/Component.hpp>
+#include <WIMAC/StationManager.hpp>
+#include <WIMAC/Logger.hpp>
+#include <WIMAC/frame/DataCollector.hpp>
+#include <WIMAC/frame/TimingControl.hpp>
+#include <WIMAC/scheduler/Interface.hpp>
+#include <WIMAC/scheduler/Scheduler.hpp>
+#include <WIMAC/services/ConnectionManager.hpp>
+
+#include <algorithm>
+
+using namespace wimac::service;
+
+STATIC_FACTORY_REGISTER_WITH_CREATOR(
+    wimac::service::SleepControl,
+    wns::ldk::ControlServiceInterface,
+    "wimac.services.SleepControl",
+    wns::ldk::CSRConfigCreator);
+
+SleepControl::SleepControl( wns::ldk::ControlServiceRegistry* csr,
+                            wns::pyconfig::View& config ) :
+    wns::ldk::ControlService(csr),
+    idleFramesBeforeSleep_(config.get<ConnectionIdentifier::Frames>("idleFramesBeforeSleep")),
+    initialSleepWindow_(config.get<ConnectionIdentifier::Frames>("initialSleepWindow")),
+    finalSleepWindow_(config.get<ConnectionIdentifier::Frames>("finalSleepWindow")),
+    listeningWindow_(config.get<ConnectionIdentifier::Frames>("listeningWindow")),
+    dlSchedulerName_(config.get<std::string>("dlSchedulerName")),
+    ulSchedulerName_(config.get<std::string>("ulSchedulerName")),
+    state_(Awake),
+    idleFrames_(0),
+    sleepWindow_(0),
+    remaining_(0)
+{
+    assure(initialSleepWindow_ > 0, "initialSleepWindow must be at least one frame");
+    assure(finalSleepWindow_ >= initialSleepWindow_, "finalSleepWindow must not be below initialSleepWindow");
+    assure(listeningWindow_ > 0, "listeningWindow must be at least one frame");
+
+    friends_.layer = NULL;
+    friends_.connectionManager = NULL;
+    friends_.timingControl = NULL;
+}
+
+void
+SleepControl::onCSRCreated()
+{
+    friends_.layer = dynamic_cast<wimac::Component*>(getCSR()->getLayer());
+    assure(friends_.layer, "SleepControl needs a wimac::Component");
+
+    assure(friends_.layer->getStationType() != wns::service::dll::StationTypes::AP(),
+           "SleepControl is only available for subscriber stations");
+
+    friends_.connectionManager = friends_.layer
+        ->getManagementService<wimac::service::ConnectionManager>("connectionManager");
+    assure(friends_.connectionManager,
+           "ConnectionManager must be of type wimac::service::ConnectionManager");
+
+    wns::ldk::fcf::FrameBuilder* frameBuilder =
+        friends_.layer->getFUN()->findFriend<wns::ldk::fcf::FrameBuilder*>("frameBuilder");
+
+    friends_.timingControl = dynamic_cast<wimac::frame::TimingControl*>(
+        frameBuilder->getTimingControl());
+    assure(friends_.timingControl, "SleepControl needs the wimac TimingControl");
+
+    // decide at each frame start, before the activations of the frame
+    frameBuilder->attachObserver(this);
+}
+
+void
+SleepControl::messageNewFrame()
+{
+    if (!friends_.connectionManager->getConnectionWithID(0))
+    {
+        // not associated (anymore)
+        if (state_ != Awake)
+            wakeUp();
+        return;
+    }
+
+    switch (state_)
+    {
+    case Awake:
+        if (hasUplinkTraffic() || hasDownlinkTraffic() || hasScheduledTraffic())
+            idleFrames_ = 0;
+        else if (++idleFrames_ >= idleFramesBeforeSleep_)
+            enterSleep(initialSleepWindow_);
+        break;
+
+    case Sleeping:
+        if (hasUplinkTraffic())
+        {
+            wakeUp();
+            break;
+        }
+
+        if (--remaining_ > 0)
+        {
+            setListening(false, remaining_);
+            break;
+        }
+
+        LOG_INFO(friends_.layer->getName(), ": SleepControl listening for ", listeningWindow_, " frames");
+        state_ = Listening;
+        remaining_ = listeningWindow_;
+        setListening(true, 0);
+        break;
+
+    case Listening:
+        if (hasUplinkTraffic() || hasDownlinkTraffic())
+        {
+            wakeUp();
+            break;
+        }
+
+        // stay until the bursts scheduled ahead have been sent
+        if (remaining_ > 1 || !hasScheduledTraffic())
+            --remaining_;
+
+        if (remaining_ == 0)
+            enterSleep(std::min(2 * sleepWindow_, finalSleepWindow_));
+        break;
+    }
+}
+
+void
+SleepControl::enterSleep(ConnectionIdentifier::Frames window)
+{
+    LOG_INFO(friends_.layer->getName(), ": SleepControl sleeping for ", window, " frames");
+
+    state_ = Sleeping;
+    sleepWindow_ = window;
+    remaining_ = window;
+    setListening(false, remaining_);
+}
+
+void
+SleepControl::wakeUp()
+{
+    LOG_INFO(friends_.layer->getName(), ": SleepControl waking up");
+
+    state_ = Awake;
+    idleFrames_ = 0;
+    sleepWindow_ = 0;
+    remaining_ = 0;
+    setListening(true, 0);
+}
+
+void
+SleepControl::setListening(bool listening, ConnectionIdentifier::Frames notListening)
+{
+    friends_.timingControl->setSleeping(!listening);
+
+    // stands in for the MOB_SLP-REQ/RSP exchange
+    wimac::Component* baseStation = getBaseStation();
+    if (baseStation == NULL)
+        return;
+
+    baseStation->getManagementService<wimac::service::ConnectionManager>("connectionManager")
+        ->setNotListening(friends_.layer->getID(), notListening);
+}
+
+bool
+SleepControl::hasUplinkTraffic() const
+{
+    return friends_.layer->getTotalQueuedPDUs() > 0;
+}
+
+bool
+SleepControl::hasDownlinkTraffic() const
+{
+    wimac::Component* baseStation = getBaseStation();
+    if (baseStation == NULL)
+        return false;
+
+    wimac::frame::DataCollector* dlCollector =
+        baseStation->getFUN()->findFriend<wimac::frame::DataCollector*>(dlSchedulerName_);
+    assure(dlCollector && dlCollector->getTxScheduler(), "BS has no DL scheduler");
+
+    wns::scheduler::queue::QueueInterface* queue = dlCollector->getTxScheduler()->getQueue();
+
+    ConnectionIdentifiers cis = baseStation
+        ->getManagementService<wimac::service::ConnectionManager>("connectionManager")
+        ->getOutgoingConnections(friends_.layer->getID());
+
+    for (ConnectionIdentifiers::const_iterator it = cis.begin(); it != cis.end(); ++it)
+    {
+        if (baseStation->getQueueOccupancy((*it)->cid_).pdus > 0
+            || queue->queueHasPDUs((*it)->cid_))
+            return true;
+    }
+    return false;
+}
+
+bool
+SleepControl::hasScheduledTraffic() const
+{
+    wimac::Component* baseStation = getBaseStation();
+    if (baseStation == NULL)
+        return false;
+
+    wimac::frame::DataCollector* dlCollector =
+        baseStation->getFUN()->findFriend<wimac::frame::DataCollector*>(dlSchedulerName_);
+    wimac::frame::DataCollector* ulCollector =
+        baseStation->getFUN()->findFriend<wimac::frame::DataCollector*>(ulSchedulerName_);
+    assure(dlCollector && ulCollector, "BS has no DL or UL DataCollector");
+
+    wimac::scheduler::Scheduler* dlScheduler =
+        dynamic_cast<wimac::scheduler::Scheduler*>(dlCollector->getTxScheduler());
+    wimac::scheduler::Scheduler* ulScheduler =
+        dynamic_cast<wimac::scheduler::Scheduler*>(ulCollector->getRxScheduler());
+
+    const wns::node::Interface* node = friends_.layer->getNode();
+
+    return (dlScheduler && dlScheduler->hasScheduledBurstsFor(node))
+        || (ulScheduler && ulScheduler->hasScheduledBurstsFor(node));
+}
+
+wimac::Component*
+SleepControl::getBaseStation() const
+{
+    ConnectionIdentifierPtr ci = friends_.connectionManager->getConnectionWithID(0);
+    if (!ci)
+        return NULL;
+
+    return dynamic_cast<wimac::Component*>(
+        TheStationManager::getInstance()->getStationByID(ci->baseStation_));
+}
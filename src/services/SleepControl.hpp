@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#ifndef WIMAC_SERVICES_SLEEPCONTROL_HPP
+#define WIMAC_SERVICES_SLEEPCONTROL_HPP
+
+#include <WNS/ldk/ControlServiceInterface.hpp>
+#include <WNS/ldk/fcf/NewFrameProviderObserver.hpp>
+#include <WNS/pyconfig/View.hpp>
+
+#include <WIMAC/ConnectionIdentifier.hpp>
+
+namespace wimac {
+    class Component;
+    namespace frame {
+        class TimingControl;
+    }
+}
+
+namespace wimac { namespace service {
+
+        class ConnectionManager;
+
+        /**
+         * @brief Sleep mode of a subscriber station (power saving class I).
+         *
+         * After idleFramesBeforeSleep frames without data in either
+         * direction, the station sleeps: its TimingControl skips the
+         * frames and the BS neither schedules nor grants it. Sleep windows
+         * start at initialSleepWindow frames and double up to
+         * finalSleepWindow, separated by listening windows in which the
+         * station receives frames again. Data queued for the station at
+         * the BS is indicated during a listening window and ends the sleep,
+         * as does own uplink data at any time.
+         *
+         * Idle mode is the same with a long final sleep window acting as
+         * paging cycle.
+         */
+        class SleepControl :
+            public wns::ldk::ControlService,
+            public wns::ldk::fcf::NewFrameObserver
+        {
+        public:
+            enum State {
+                Awake,
+                Sleeping,
+                Listening
+            };
+
+            SleepControl( wns::ldk::ControlServiceRegistry* csr,
+                          wns::pyconfig::View& config );
+
+            void onCSRCreated();
+
+            /**
+             * @brief Called by the FrameBuilder at each frame start, before
+             * the TimingControl processes the activations of the frame.
+             */
+            void messageNewFrame();
+
+            State
+            getState() const
+            {
+                return state_;
+            }
+
+        private:
+            void
+            enterSleep(ConnectionIdentifier::Frames window);
+
+            void
+            wakeUp();
+
+            void
+            setListening(bool listening, ConnectionIdentifier::Frames notListening);
+
+            bool
+            hasUplinkTraffic() const;
+
+            /**
+             * @brief True if the BS holds data for this station (the
+             * traffic indication).
+             */
+            bool
+            hasDownlinkTraffic() const;
+
+            /**
+             * @brief True if a schedule the BS has already computed (the
+             * current one or the lookahead one) holds bursts or grants for
+             * this station.
+             */
+            bool
+            hasScheduledTraffic() const;
+
+            wimac::Component*
+            getBaseStation() const;
+
+            ConnectionIdentifier::Frames idleFramesBeforeSleep_;
+            ConnectionIdentifier::Frames initialSleepWindow_;
+            ConnectionIdentifier::Frames finalSleepWindow_;
+            ConnectionIdentifier::Frames listeningWindow_;
+            std::string dlSchedulerName_;
+            std::string ulSchedulerName_;
+
+            State state_;
+            ConnectionIdentifier::Frames idleFrames_;
+            ConnectionIdentifier::Frames sleepWindow_;
+            ConnectionIdentifier::Frames remaining_;
+
+            struct {
+                wimac::Component* layer;
+                wimac::service::ConnectionManager* connectionManager;
+                wimac::frame::TimingControl* timingControl;
+            } friends_;
+        };
+}}
+
+#endif // WIMAC_SERVICES_SLEEPCONTROL_HPP
@@ -82,7 +82,17 @@ namespace wimac { namespace tests {
             void
             processedPackets();
 
-        private:
+        protected:
+            /**
+             * @brief PyConfig expression for the ACK aggregation, none
+             * if empty
+             */
+            virtual std::string
+            getAggregation() const { return ""; }
+
+            wns::ldk::CompoundPtr
+            createACK( wns::ldk::ClassificationID cid );
+
             virtual void
             setUpTestFUs();
 
@@ -107,7 +117,13 @@ namespace wimac { namespace tests {
         ACKSwitchTest::setUpTestFUs()
         {
             wns::pyconfig::Parser emptyconfig;
-            ackSwitch = new wimac::ACKSwitch(getFUN(), emptyconfig);
+
+            wns::pyconfig::Parser switchConfig;
+            if (!getAggregation().empty())
+                switchConfig.loadString(
+                    "from wimac.FUs import ACKAggregation\n"
+                    "aggregation = " + getAggregation() + "\n");
+            ackSwitch = new wimac::ACKSwitch(getFUN(), switchConfig);
 
             std::stringstream ss;
             ss << "from openwns.ARQ import CumulativeACK\n"
@@ -269,5 +285,116 @@ namespace wimac { namespace tests {
             classifierCommand = classifier->getCommand(compound->getCommandPool());
             CPPUNIT_ASSERT_EQUAL( classifierCommand->peer.id , cid );
         }
+
+        wns::ldk::CompoundPtr
+        ACKSwitchTest::createACK( wns::ldk::ClassificationID cid )
+        {
+            wns::ldk::CompoundPtr compound(getFUN()->createCompound());
+            arq->activateCommand(compound->getCommandPool());
+            arq->getCommand(compound->getCommandPool())->peer.type =
+                wns::ldk::arq::CumulativeACKCommand::RR;
+
+            classifier->activateCommand(compound->getCommandPool());
+            classifier->getCommand(compound->getCommandPool())->peer.id = cid;
+            return compound;
+        }
+
+        class ACKAggregationTest :
+            public ACKSwitchTest
+        {
+            CPPUNIT_TEST_SUITE( ACKAggregationTest );
+            CPPUNIT_TEST( bitmap );
+            CPPUNIT_TEST_SUITE_END();
+        public:
+            void
+            bitmap();
+
+        private:
+            virtual std::string
+            getAggregation() const { return "ACKAggregation(mode = 'bitmap', frameBuilder = None)"; }
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( ACKAggregationTest );
+
+        void
+        ACKAggregationTest::bitmap()
+        {
+            wns::ldk::ClassificationID const cid = 3;
+            sendCompound(createACK(cid));
+            sendCompound(createACK(cid));
+            sendCompound(createACK(cid + 1));
+
+            // held back until the next frame starts
+            CPPUNIT_ASSERT_EQUAL((unsigned int)3, compoundsAccepted());
+            CPPUNIT_ASSERT_EQUAL((unsigned int)0, compoundsSent());
+
+            ackSwitch->messageNewFrame();
+
+            // one compound per basic connection
+            CPPUNIT_ASSERT_EQUAL((unsigned int)2, compoundsSent());
+            wns::ldk::CompoundPtr aggregate = getLowerStub()->sent[0];
+            CPPUNIT_ASSERT_EQUAL( classifier->getCommand(aggregate->getCommandPool())->peer.id, cid * 7 );
+
+            receiveCompound(aggregate);
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)2, compoundsDelivered());
+            for (int i = 0; i < 2; ++i)
+            {
+                wns::ldk::CompoundPtr ack = getUpperStub()->received[i];
+                CPPUNIT_ASSERT_EQUAL( classifier->getCommand(ack->getCommandPool())->peer.id, cid );
+            }
+        }
+    
+        class ACKCumulativeTest :
+            public ACKSwitchTest
+        {
+            CPPUNIT_TEST_SUITE( ACKCumulativeTest );
+            CPPUNIT_TEST( cumulative );
+            CPPUNIT_TEST_SUITE_END();
+        public:
+            void
+            cumulative();
+
+        private:
+            virtual std::string
+            getAggregation() const { return "ACKAggregation(mode = 'cumulative', frameBuilder = None)"; }
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( ACKCumulativeTest );
+
+        void
+        ACKCumulativeTest::cumulative()
+        {
+            wns::ldk::ClassificationID const cid = 3;
+            wns::ldk::CompoundPtr older = createACK(cid);
+            wns::ldk::CompoundPtr newer = createACK(cid);
+            sendCompound(older);
+            sendCompound(newer);
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)2, compoundsAccepted());
+            CPPUNIT_ASSERT_EQUAL((unsigned int)0, compoundsSent());
+
+            ackSwitch->messageNewFrame();
+
+            // only the newer ACK is carried
+            CPPUNIT_ASSERT_EQUAL((unsigned int)1, compoundsSent());
+            wns::ldk::CompoundPtr aggregate = getLowerStub()->sent[0];
+            CPPUNIT_ASSERT_EQUAL( classifier->getCommand(aggregate->getCommandPool())->peer.id, cid * 7 );
+
+            const AckSwitchCommand::ACKs& acks =
+                ackSwitch->getCommand(aggregate->getCommandPool())->peer.acks;
+            CPPUNIT_ASSERT_EQUAL( (std::size_t)1, acks.size() );
+            CPPUNIT_ASSERT( acks[0].ack == newer );
+
+            receiveCompound(aggregate);
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)1, compoundsDelivered());
+            wns::ldk::CompoundPtr ack = getUpperStub()->received[0];
+            CPPUNIT_ASSERT_EQUAL( classifier->getCommand(ack->getCommandPool())->peer.id, cid );
+
+            // nothing left for the next frame
+            ackSwitch->messageNewFrame();
+            CPPUNIT_ASSERT_EQUAL((unsigned int)1, compoundsSent());
+        }
     }
 }
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/PERTable.hpp>
+
+#include <WNS/pyconfig/Parser.hpp>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+namespace wimac { namespace tests {
+
+        /**
+         * @brief Smooth waterfall curves, one per PhyMode, 3 dB apart
+         */
+        class WaterfallMapping :
+            public PERTable::MappingInterface
+        {
+        public:
+            virtual int
+            getNumberOfPhyModes() const
+            {
+                return 3;
+            }
+
+            virtual double
+            getPER(int phyMode, double sinr, unsigned int blockSize) const
+            {
+                double ber = 0.5 * erfc(std::sqrt(std::pow(10.0, (sinr - 3.0 * phyMode) / 10.0)));
+                return 1.0 - std::pow(1.0 - ber, double(blockSize));
+            }
+        };
+
+        class PERTableTest :
+            public CppUnit::TestFixture
+        {
+            CPPUNIT_TEST_SUITE( PERTableTest );
+            CPPUNIT_TEST( gridPoints );
+            CPPUNIT_TEST( accuracy );
+            CPPUNIT_TEST( outsideTable );
+            CPPUNIT_TEST( tighterBound );
+            CPPUNIT_TEST( batchLookup );
+            CPPUNIT_TEST_SUITE_END();
+
+        public:
+            void setUp();
+            void tearDown();
+
+            void gridPoints();
+            void accuracy();
+            void outsideTable();
+            void tighterBound();
+            void batchLookup();
+
+        private:
+            PERTablePtr
+            createTable(double maxError) const;
+
+            WaterfallMapping mapping_;
+            PERTablePtr table_;
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( PERTableTest );
+
+        PERTablePtr
+        PERTableTest::createTable(double maxError) const
+        {
+            std::stringstream ss;
+            ss << "minSINR = -5.0\n"
+               << "maxSINR = 20.0\n"
+               << "sinrResolution = 0.25\n"
+               << "minBlockSize = 0\n"
+               << "maxBlockSize = 2048\n"
+               << "blockSizeResolution = 64\n"
+               << "maxError = " << maxError << "\n"
+               << "checkPoints = 4\n";
+            wns::pyconfig::Parser config;
+            config.loadString(ss.str());
+
+            return PERTablePtr(new PERTable(mapping_, config));
+        }
+
+        void
+        PERTableTest::setUp()
+        {
+            table_ = createTable(1e-3);
+        }
+
+        void
+        PERTableTest::tearDown()
+        {
+            table_ = PERTablePtr();
+        }
+
+        void
+        PERTableTest::gridPoints()
+        {
+            // No cell is evaluated exactly with this bound
+            PERTablePtr table = createTable(1.0);
+
+            for (int mode = 0; mode < 3; ++mode)
+            {
+                double per = -1.0;
+                CPPUNIT_ASSERT( table->lookup(mode, 8.0, 128, per) );
+                CPPUNIT_ASSERT_DOUBLES_EQUAL(mapping_.getPER(mode, 8.0, 128), per, 1e-12);
+            }
+        }
+
+        void
+        PERTableTest::accuracy()
+        {
+            int hits = 0;
+
+            for (int mode = 0; mode < 3; ++mode)
+            {
+                for (double sinr = -5.0; sinr < 20.0; sinr += 0.0137)
+                {
+                    for (unsigned int blockSize = 1; blockSize < 2048; blockSize += 37)
+                    {
+                        double per;
+                        if (!table_->lookup(mode, sinr, blockSize, per))
+                            continue;
+
+                        ++hits;
+                        CPPUNIT_ASSERT_DOUBLES_EQUAL(
+                            mapping_.getPER(mode, sinr, blockSize), per, table_->getMaxError());
+                    }
+                }
+            }
+
+            // Most of the table must be usable for the test to be meaningful
+            CPPUNIT_ASSERT( hits > 3 * 1825 * 56 / 2 );
+        }
+
+        void
+        PERTableTest::outsideTable()
+        {
+            double per = -1.0;
+            CPPUNIT_ASSERT( !table_->lookup(0, -5.1, 640, per) );
+            CPPUNIT_ASSERT( !table_->lookup(0, 20.0, 640, per) );
+            CPPUNIT_ASSERT( !table_->lookup(0, 10.0, 2048, per) );
+            CPPUNIT_ASSERT( !table_->lookup(0, 10.0, 5000, per) );
+            CPPUNIT_ASSERT_EQUAL( -1.0, per );
+        }
+
+        void
+        PERTableTest::tighterBound()
+        {
+            PERTablePtr coarse = createTable(1e-1);
+            PERTablePtr fine = createTable(1e-6);
+
+            CPPUNIT_ASSERT( coarse->getNumberOfExactCells() <= table_->getNumberOfExactCells() );
+            CPPUNIT_ASSERT( table_->getNumberOfExactCells() < fine->getNumberOfExactCells() );
+        }
+
+        void
+        PERTableTest::batchLookup()
+        {
+            std::vector<int> phyModes;
+            std::vector<double> sinrs;
+            std::vector<unsigned int> blockSizes;
+
+            for (double sinr = -6.0; sinr < 21.0; sinr += 0.7)
+            {
+                phyModes.push_back(phyModes.size() % 3);
+                sinrs.push_back(sinr);
+                blockSizes.push_back(100 + 53 * phyModes.size());
+            }
+
+            std::size_t n = sinrs.size();
+            std::vector<double> pers(n, -1.0);
+            std::vector<char> found(n, 1);
+
+            table_->lookup(n, &phyModes[0], &sinrs[0], &blockSizes[0], &pers[0], &found[0]);
+
+            for (std::size_t k = 0; k < n; ++k)
+            {
+                double per = -1.0;
+                bool single = table_->lookup(phyModes[k], sinrs[k], blockSizes[k], per);
+
+                CPPUNIT_ASSERT_EQUAL( single, found[k] != 0 );
+                CPPUNIT_ASSERT_EQUAL( per, pers[k] );
+            }
+        }
+}}
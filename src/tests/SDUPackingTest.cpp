@@ -0,0 +1,204 @@
+/*******************************************************************************
+ * This file is part of openWNS (open Wireless Network Simulator)
+ * _____________________________________________________________________________
+ *
+ * Copyright (C) 2004-2009
+ * Chair of Communication Networks (ComNets)
+ * Kopernikusstr. 5, D-52074 Aachen, Germany
+ * email: info@openwns.org
+ * www: http://www.openwns.org
+ * _____________________________________________________________________________
+ *
+ * openWNS is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License version 2 as published by the
+ * Free Software Foundation;
+ *
+ * openWNS is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ******************************************************************************/
+
+#include <WIMAC/SDUPacking.hpp>
+
+#include <WNS/ldk/tests/FUTestBase.hpp>
+#include <WNS/ldk/Classifier.hpp>
+#include <WNS/ldk/helper/FakePDU.hpp>
+#include <WNS/pyconfig/Parser.hpp>
+#include <WNS/simulator/ISimulator.hpp>
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace wimac { namespace tests {
+
+        class SingleCIDPolicy
+        {
+        public:
+            SingleCIDPolicy( wns::ldk::fun::FUN* ) {}
+            wns::ldk::ClassificationID classify( const wns::ldk::CompoundPtr& ) { return 5; }
+        };
+
+        class SDUPackingTest :
+            public wns::ldk::tests::FUTestBase
+        {
+            CPPUNIT_TEST_SUITE( SDUPackingTest );
+            CPPUNIT_TEST( pack );
+            CPPUNIT_TEST( timeout );
+            CPPUNIT_TEST( singleSDU );
+            CPPUNIT_TEST_SUITE_END();
+        public:
+            void
+            pack();
+
+            void
+            timeout();
+
+            void
+            singleSDU();
+
+        private:
+            wns::ldk::CompoundPtr
+            createSDU( Bit bits );
+
+            virtual void
+            setUpTestFUs();
+
+            virtual void
+            tearDownTestFUs();
+
+            virtual wns::ldk::FunctionalUnit*
+            getUpperTestFU() const;
+
+            virtual wns::ldk::FunctionalUnit*
+            getLowerTestFU() const;
+
+            wimac::SDUPacking* packing;
+            wns::ldk::Classifier<SingleCIDPolicy>* classifier;
+        };
+
+        CPPUNIT_TEST_SUITE_REGISTRATION( SDUPackingTest );
+
+        void
+        SDUPackingTest::setUpTestFUs()
+        {
+            wns::pyconfig::Parser emptyconfig;
+
+            wns::pyconfig::Parser config;
+            config.loadString(
+                "from wimac.FUs import SDUPacking\n"
+                "packing = SDUPacking(targetSize = 250, maxDelay = 0.001, subHeaderSize = 0)\n");
+
+            packing = new wimac::SDUPacking(getFUN(), config.getView("packing"));
+            classifier = new wns::ldk::Classifier<SingleCIDPolicy>(getFUN(), emptyconfig);
+
+            getFUN()->addFunctionalUnit("testFU", packing);
+            getFUN()->addFunctionalUnit("classifier", classifier);
+        }
+
+        void
+        SDUPackingTest::tearDownTestFUs()
+        {
+        }
+
+        wns::ldk::FunctionalUnit*
+        SDUPackingTest::getUpperTestFU() const
+        {
+            return packing;
+        }
+
+        wns::ldk::FunctionalUnit*
+        SDUPackingTest::getLowerTestFU() const
+        {
+            return packing;
+        }
+
+        wns::ldk::CompoundPtr
+        SDUPackingTest::createSDU( Bit bits )
+        {
+            wns::ldk::CompoundPtr compound(
+                new wns::ldk::Compound(getFUN()->getProxy()->createCommandPool(),
+                                       wns::osi::PDUPtr(new wns::ldk::helper::FakePDU(bits))));
+            classifier->activateCommand(compound->getCommandPool())->peer.id = 5;
+            return compound;
+        }
+
+        void
+        SDUPackingTest::pack()
+        {
+            wns::ldk::CompoundPtr first = createSDU(100);
+            wns::ldk::CompoundPtr second = createSDU(100);
+            sendCompound(first);
+            sendCompound(second);
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)2, compoundsAccepted());
+            CPPUNIT_ASSERT_EQUAL((unsigned int)0, compoundsSent());
+
+            // does not fit, the first two leave packed
+            sendCompound(createSDU(100));
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)1, compoundsSent());
+            wns::ldk::CompoundPtr pdu = getLowerStub()->sent[0];
+            CPPUNIT_ASSERT( getFUN()->getProxy()->commandIsActivated(pdu->getCommandPool(), packing) );
+
+            const SDUPackingCommand::SDUs& sdus =
+                packing->getCommand(pdu->getCommandPool())->peer.sdus;
+            CPPUNIT_ASSERT_EQUAL( (std::size_t)2, sdus.size() );
+            CPPUNIT_ASSERT( sdus[0] == first );
+            CPPUNIT_ASSERT( sdus[1] == second );
+
+            // the peer delivers them one by one
+            receiveCompound(pdu);
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)2, compoundsDelivered());
+            CPPUNIT_ASSERT_EQUAL( first->getLengthInBits(),
+                                  getUpperStub()->received[0]->getLengthInBits() );
+        }
+
+        void
+        SDUPackingTest::timeout()
+        {
+            sendCompound(createSDU(100));
+            sendCompound(createSDU(100));
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)0, compoundsSent());
+
+            // maxDelay after the first SDU
+            wns::simulator::getEventScheduler()->processOneEvent();
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)1, compoundsSent());
+            wns::ldk::CompoundPtr pdu = getLowerStub()->sent[0];
+            CPPUNIT_ASSERT_EQUAL( (std::size_t)2,
+                                  packing->getCommand(pdu->getCommandPool())->peer.sdus.size() );
+        }
+
+        void
+        SDUPackingTest::singleSDU()
+        {
+            // alone in its PDU after the timeout
+            wns::ldk::CompoundPtr sdu = createSDU(100);
+            sendCompound(sdu);
+            wns::simulator::getEventScheduler()->processOneEvent();
+
+            // fills a PDU on its own
+            wns::ldk::CompoundPtr large = createSDU(300);
+            sendCompound(large);
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)2, compoundsSent());
+            for (int i = 0; i < 2; ++i)
+            {
+                wns::ldk::CompoundPtr pdu = getLowerStub()->sent[i];
+                CPPUNIT_ASSERT( pdu == (i == 0 ? sdu : large) );
+                CPPUNIT_ASSERT( !getFUN()->getProxy()->commandIsActivated(pdu->getCommandPool(), packing) );
+            }
+
+            // passed up unchanged
+            receiveCompound(large);
+
+            CPPUNIT_ASSERT_EQUAL((unsigned int)1, compoundsDelivered());
+            CPPUNIT_ASSERT( getUpperStub()->received[0] == large );
+        }
+    }
+}